@@ -3,17 +3,25 @@
 
 #include <vector>
 #include "memsys.h"
+#include "snapshot.h"
 
 // Cache simulator
 class Cache{
+public:
+    // Access kinds
+    enum class AccessType{
+        READ, WRITE
+    };
+
 private:
     // Single cache line
     struct CacheLine{
         bool valid = false;
+        bool dirty = false;         // Modified since fill (write-back only)
         int tag = 0;
 
         // LRU, LFU, FIFO
-        int lastUsed = 0, frequency = 0, insertedAt = 0;
+        long long lastUsed = 0, frequency = 0, insertedAt = 0;
     };                       
 
     // Cache replacement policies
@@ -30,17 +38,39 @@ private:
     Cache* next;                                // Next cache level
     Memory* memory;                             // Backing memory
     ReplacementPolicy policy;                   // Active policy
-    int globalTime;
+    long long globalTime;
+
+    // Write handling
+    static const int WORD_SIZE = 4;             // Bytes per write-through store
+    bool writeBack, writeAllocate;
 
-    int hits, misses;
+    long long hits, misses;
+    long long writes, writebacks, writeThroughs;
+
+    CacheLine* selectVictim(int index);         // Empty line or policy victim of a set
+    void writeLine(int address);                // Write back a dirty line below
+    void acceptWriteback(int address);          // Absorb a line written back from above
+    void writeWord(int address);                // Forward a store below
 
 public:
     Cache(int cacheSize, int blockSize, int associativity, Cache* next, Memory* memory);
     
-    bool access(int address);                   // Access cache address
+    bool access(int address, AccessType type = AccessType::READ);   // Access cache address
+    size_t accessBatch(const int* addresses, size_t count, unsigned char* hitBitmap = nullptr);  // Batched access, returns hits
     bool setPolicy(std::string policyName);    // Set replacement policy
+    bool setWritePolicy(std::string policyName);       // write_back / write_through
+    bool setAllocatePolicy(std::string policyName);    // write_allocate / no_write_allocate
     void invalidateRange(int start, int size);  // Invalidate cache range
+    void invalidateRanges(const std::vector<std::pair<int,int>>& ranges);  // Batched {start, size} invalidation
     void stats(int level);                      // Print cache stats
+    void getCounters(long long& hitCount, long long& missCount) const;  // Hit / miss counters
+    Cache* nextLevel() const;                   // Next cache level (nullptr at last level)
+
+    void save(SnapshotWriter& out) const;       // Serialize this and lower levels
+    bool load(SnapshotReader& in);              // Restore this and lower levels
 };
 
+bool isPowerOfTwo(int x);
+bool validCacheConfig(int cacheSize, int blockSize, int associativity);    // Geometry check
+
 #endif
\ No newline at end of file
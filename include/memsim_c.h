@@ -0,0 +1,71 @@
+#ifndef MEMSIM_C_H
+#define MEMSIM_C_H
+
+/* C API for embedding the simulator (link bin/libmemsim.a and libstdc++).
+ *
+ * One memsim handle owns a main memory and an L1 -> L2 -> Memory cache
+ * hierarchy. Hit bitmaps hold one bit per input element (bit i % 8 of
+ * byte i / 8) and must be at least (count + 7) / 8 bytes long. */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MEMSIM_API_VERSION 2
+
+typedef struct memsim memsim;
+
+typedef struct {
+    int memory_size;
+    const char* allocator;          /* first_fit, best_fit, worst_fit, buddy, tlsf, slab */
+    int l1_size, l1_block, l1_assoc;
+    int l2_size, l2_block, l2_assoc;
+    const char* policy;             /* fifo, lru, lfu */
+} memsim_config;
+
+typedef enum {
+    MEMSIM_MALLOC, MEMSIM_FREE, MEMSIM_ACCESS, MEMSIM_WRITE
+} memsim_event_type;
+
+typedef struct {
+    memsim_event_type type;
+    uint64_t handle;                /* caller's allocation handle (malloc / free) */
+    int value;                      /* size (malloc) or address (access / write) */
+} memsim_event;
+
+typedef struct {
+    int64_t hits, misses;
+} memsim_level_counters;
+
+int memsim_api_version(void);
+void memsim_default_config(memsim_config* config);
+memsim* memsim_create(const memsim_config* config);    /* NULL on invalid configuration */
+void memsim_destroy(memsim* sim);
+
+/* Write policy of cache level 1..N; returns 1 on success */
+int memsim_set_write_policy(memsim* sim, int level, int write_back, int write_allocate);
+
+int memsim_malloc(memsim* sim, int size);               /* block id, or -1 */
+int memsim_free(memsim* sim, int id);                   /* 1 on success */
+
+/* Read addresses[0..count); returns number of hits */
+size_t memsim_access_batch(memsim* sim, const int* addresses, size_t count, uint8_t* hit_bitmap);
+
+/* Replay events; a bit is set for a hit, a successful malloc or a matched free.
+ * Handles persist across calls. Returns the number of set bits. */
+size_t memsim_replay_events(memsim* sim, const memsim_event* events, size_t count, uint8_t* result_bitmap);
+
+/* Bytes moved between the last cache level and memory */
+void memsim_memory_traffic(const memsim* sim, int64_t* read_bytes, int64_t* write_bytes);
+
+/* Fill up to max_levels counters (L1 first); returns the number of cache levels */
+int memsim_counters(const memsim* sim, memsim_level_counters* out, int max_levels);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -4,15 +4,29 @@
 #include<string>
 #include<vector>
 #include<unordered_map>
+#include "snapshot.h"
 
 // Memory allocator
 class Memory {
+public:
+    // Block moved by heap compaction (id is unchanged)
+    struct Relocation{
+        int id, oldStart, newStart, size;
+    };
+
 private:
     struct Block;                       // Memory block structure
 
+    // TLSF physical block (free list links are block starts, -1 = none)
+    struct TlsfBlock{
+        int size, id;
+        int prevPhys, prevFree, nextFree;
+        bool free;
+    };
+
     // Supported allocation strategies
     enum class AllocatorType{
-        FIRST_FIT, BEST_FIT, WORST_FIT, BUDDY
+        FIRST_FIT, BEST_FIT, WORST_FIT, BUDDY, TLSF, SLAB
     };
 
     Block* head;                        // Head of memory block list
@@ -25,27 +39,81 @@ private:
     std::vector<std::vector<int>> freeLists;
     std::unordered_map<int,std::pair<int,int>> buddyAllocated;
 
+    // TLSF Allocation
+    static const int TLSF_SL_LOG2 = 4;          // 16 second-level lists per class
+    static const int TLSF_FL_COUNT = 28;        // Covers sizes up to 2^31
+    std::unordered_map<int,TlsfBlock> tlsfBlocks;       // Physical blocks by start
+    std::unordered_map<int,int> tlsfAllocated;          // id -> block start
+    unsigned int tlsfFlBitmap;                          // Non-empty first-level classes
+    std::vector<unsigned int> tlsfSlBitmap;             // Non-empty second-level lists
+    std::vector<std::vector<int>> tlsfHeads;            // Free list heads [fl][sl]
+
+    // Slab Allocation
+    static const int SLAB_LARGE = -2;                   // Page class of large-object runs
+    int slabPageSize;                                   // Bytes per slab page
+    std::vector<int> slabClasses;                       // Object size per class
+    std::vector<int> slabPartial;                       // Per-class list of pages with free objects
+    int slabFreeHead;                                   // List of unassigned pages
+    std::vector<int> slabPrev, slabNext;                // Page links within those lists (-1 = none)
+    std::vector<std::vector<int>> slabPageFree;         // Free objects per page
+    std::vector<int> slabPageClass, slabPageInUse;      // Per-page class (-1 free) and live objects
+    std::unordered_map<int,std::pair<int,int>> slabAllocated;  // id -> {start, requested}
+
     // Statistics utilities
     int totalAllocs = 0, failedAllocs = 0, usedMemory = 0, internalFrag = 0;
 
+    // Memory traffic from the cache hierarchy
+    long long readBytes = 0, writeBytes = 0;
+
+    // Heap compaction (list allocators only)
+    bool compaction = false;
+    int compactions = 0, compactionRecovered = 0, bytesRelocated = 0;
+    std::vector<Relocation> lastRelocations;    // old -> new map of last compaction
+
     int allocate(Block* block, int size);   // Internal allocation helper
     int mallocFF(int size);                 // First Fit
     int mallocBF(int size);                 // Best Fit
     int mallocWF(int size);                 // Worst Fit
+    int mallocFit(int size);                // Dispatch FF / BF / WF
+    void compact();                         // Slide used blocks to low addresses
 
     int buddyMalloc(int size);              // Buddy allocation
     bool buddyFree(int id);                 // Buddy deallocation
+
+    void tlsfMapping(int size, int& fl, int& sl);   // Size -> (fl, sl) list
+    void tlsfInsert(int start);             // Push free block to its list
+    void tlsfRemove(int start);             // Unlink free block from its list
+    int tlsfMalloc(int size);               // TLSF allocation
+    bool tlsfFree(int id);                  // TLSF deallocation
+
+    void slabLink(int& head, int page);     // Push page on a page list
+    void slabUnlink(int& head, int page);   // Remove page from a page list
+    int slabMalloc(int size);               // Slab allocation
+    int slabMallocLarge(int size);          // Contiguous page run for large requests
+    bool slabFree(int id);                  // Slab deallocation
+
+    void clearBlocks();                     // Release block list
 public:
     Memory(int size);                       // Constructor
+    ~Memory();                              // Destructor
 
     bool setAllocator(std::string type);   // Set allocator type
+    bool isListAllocator() const;           // First / best / worst fit active
     int malloc(int size);                   // Allocate memory
     bool free(int id);                      // Free allocation
     bool access(int id);                    // Access check
+    void transfer(bool write, int bytes);   // Record line fill / write traffic
+    void getTraffic(long long& read, long long& written) const;    // Traffic counters
     bool getLastAllocation(int& start, int& size);  // Last allocation info
+    bool setCompaction(bool enabled);       // Toggle compaction on failed fits
+    bool planCompaction(int size, std::vector<Relocation>& moves) const;   // Blocks malloc(size) would move
+    bool getLastRelocations(std::vector<Relocation>& moved);   // Blocks moved by last malloc
 
     void dump();                            // Print memory layout
     void stats();                           // Print statistics
+
+    void save(SnapshotWriter& out) const;   // Serialize full state
+    bool load(SnapshotReader& in);          // Restore full state
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,76 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Binary snapshot serialization
+//
+// Snapshots are raw native-endian dumps meant to be restored by the same
+// build of the simulator; they are not a portable interchange format.
+
+// Append-only snapshot buffer
+class SnapshotWriter{
+private:
+    std::string buffer;
+
+public:
+    template<typename T>
+    void put(const T& value){
+        buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    void putBytes(const void* data, size_t size){
+        if (size == 0) return;
+        buffer.append(static_cast<const char*>(data), size);
+    }
+
+    template<typename T>
+    void putVector(const std::vector<T>& values){
+        put<int32_t>(values.size());
+        putBytes(values.data(), values.size() * sizeof(T));
+    }
+
+    const std::string& data() const { return buffer; }
+};
+
+// Sequential reader over a loaded snapshot
+class SnapshotReader{
+private:
+    const char* cur;
+    const char* end;
+
+public:
+    SnapshotReader(const std::string& data) : cur(data.data()), end(data.data() + data.size()) {}
+
+    template<typename T>
+    bool get(T& value){
+        return getBytes(&value, sizeof(T));
+    }
+
+    bool getBytes(void* data, size_t size){
+        if (size == 0) return true;
+        if ((size_t)(end - cur) < size) return false;
+        std::memcpy(data, cur, size);
+        cur += size;
+        return true;
+    }
+
+    template<typename T>
+    bool getVector(std::vector<T>& values){
+        int32_t count;
+        if (!get(count) || count < 0 || (size_t)count * sizeof(T) > remaining()) return false;
+        values.resize(count);
+        if (count == 0) return true;
+        return getBytes(values.data(), count * sizeof(T));
+    }
+
+    size_t remaining() const { return end - cur; }
+};
+
+bool saveSnapshotFile(const std::string& path, const SnapshotWriter& writer);  // Write header + payload
+bool loadSnapshotFile(const std::string& path, std::string& payload);          // Bulk read, check header
+
+#endif
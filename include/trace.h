@@ -0,0 +1,57 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "memsys.h"
+#include "cache.h"
+
+// Trace replay
+//
+// Text format, one event per line ('#' starts a comment):
+//   [SEQ] m HANDLE SIZE     allocate SIZE bytes, remembered as HANDLE
+//   [SEQ] f HANDLE          free the allocation made for HANDLE
+//   [SEQ] a ADDRESS         read ADDRESS through the cache hierarchy ('r' also accepted)
+//   [SEQ] w ADDRESS         write ADDRESS through the cache hierarchy
+// HANDLE is any token (memtrace writes real pointers as 0x...). When
+// sequence numbers are present, events are replayed in SEQ order.
+
+struct TraceEvent{
+    enum class Type{
+        MALLOC, FREE, ACCESS, WRITE
+    };
+
+    Type type;
+    unsigned long long seq;
+    std::string handle;                 // Allocation handle (malloc / free)
+    int value;                          // Size (malloc) or address (access / write)
+};
+
+struct ReplayStats{
+    long long mallocs = 0, frees = 0, accesses = 0, writes = 0;
+    long long failedAllocs = 0, unknownFrees = 0, hits = 0;
+};
+
+// One simulated system driven by a replay
+struct ReplayTarget{
+    std::string name;
+    Memory* mem = nullptr;
+    Cache* L1 = nullptr;
+    ReplayStats stats;
+    std::unordered_map<std::string,int> ids;     // handle -> simulator id
+};
+
+bool loadTrace(const std::string& path, std::vector<TraceEvent>& events, int& badLines);   // Parse and order trace
+
+int syncedMalloc(Memory* mem, Cache* L1, int size, int& relocated);    // Allocate, keep caches consistent
+
+void replayEvent(const TraceEvent& ev, ReplayTarget& target);          // Apply one event
+
+// Replay events against one system; handles map to simulator ids
+void replayTrace(const std::vector<TraceEvent>& events, Memory* mem, Cache* L1, ReplayStats& stats);
+
+// Replay events against several systems in one pass (identical input for each)
+void replayFused(const std::vector<TraceEvent>& events, std::vector<ReplayTarget>& targets);
+
+#endif
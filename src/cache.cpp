@@ -1,9 +1,34 @@
 #include "cache.h"
 #include <iostream>
 
+bool isPowerOfTwo(int x) {
+    return x > 0 && (x & (x - 1)) == 0;
+}
+
+// Cache geometry must decompose cleanly into tag | index | offset
+bool validCacheConfig(int cacheSize, int blockSize, int associativity) {
+    if (cacheSize <= 0 || blockSize <= 0 || associativity <= 0) 
+        return false;
+
+    if (cacheSize % blockSize != 0)
+        return false;
+
+    int numBlocks = cacheSize / blockSize;
+    if (numBlocks % associativity != 0)
+        return false;
+
+    if (!isPowerOfTwo(cacheSize) ||
+        !isPowerOfTwo(blockSize) ||
+        !isPowerOfTwo(associativity))
+        return false;
+
+    return true;
+}
+
 // Cache constructor
 Cache::Cache(int cacheSize, int blockSize, int associativity, Cache* next, Memory* memory) 
-    : cacheSize(cacheSize), blockSize(blockSize), associativity(associativity), next(next), memory(memory), policy(ReplacementPolicy::FIFO), globalTime(0), hits(0), misses(0)
+    : cacheSize(cacheSize), blockSize(blockSize), associativity(associativity), next(next), memory(memory), policy(ReplacementPolicy::FIFO), globalTime(0),
+      writeBack(true), writeAllocate(true), hits(0), misses(0), writes(0), writebacks(0), writeThroughs(0)
 {
     numBlocks = cacheSize / blockSize;           // Total cache blocks
     numSets = numBlocks / associativity;         // Total cache sets
@@ -13,13 +38,15 @@ Cache::Cache(int cacheSize, int blockSize, int associativity, Cache* next, Memor
 }
 
 // Access cache address
-bool Cache::access(int address){
+bool Cache::access(int address, AccessType type){
     int blockNumber = address / blockSize;      // Compute block number
     int index = blockNumber % numSets;          // Compute set index
     int tag = blockNumber / numSets;            // Compute tag
+    bool isWrite = type == AccessType::WRITE;
 
     auto& set = sets[index];
     globalTime++;
+    if (isWrite) writes++;
     
     // HIT
     for (auto& line : set){
@@ -27,25 +54,52 @@ bool Cache::access(int address){
             line.lastUsed = globalTime;
             line.frequency++;
             hits++;
+
+            if (isWrite){
+                if (writeBack) line.dirty = true;
+                else writeWord(address);
+            }
             return true;
         }
     }
 
     // MISS
     misses++;
+
+    // No-write-allocate: store goes around this level
+    if (isWrite && !writeAllocate){
+        writeWord(address);
+        return false;
+    }
+
     if (next) next->access(address);
-    else if (memory) memory->access(address);
+    else if (memory){
+        memory->access(address);
+        memory->transfer(false, blockSize);
+    }
+
+    CacheLine* victim = selectVictim(index);
+
+    // Replace victim cache line
+    victim->valid = true;
+    victim->dirty = isWrite && writeBack;
+    victim->tag = tag;
+    victim->insertedAt = globalTime;
+    victim->lastUsed = globalTime;
+    victim->frequency = 1;
+
+    if (isWrite && !writeBack) writeWord(address);
+    return false;
+}
+
+// Pick the line to fill in a set: an empty line, else the policy victim
+// (a dirty victim is written back first)
+Cache::CacheLine* Cache::selectVictim(int index){
+    auto& set = sets[index];
 
     // Fill empty line
     for (auto& line : set){
-        if (!line.valid) {
-            line.valid = true;
-            line.tag = tag;
-            line.insertedAt = globalTime;
-            line.lastUsed = globalTime;
-            line.frequency = 1;
-            return false;
-        }
+        if (!line.valid) return &line;
     }
 
     // Replacement Policy
@@ -64,13 +118,79 @@ bool Cache::access(int address){
         }
     }
 
-    // Replace victim cache line
+    // Evicting modified data
+    if (victim->dirty) writeLine((victim->tag * numSets + index) * blockSize);
+    return victim;
+}
+
+// Write a dirty line back to the next level or memory
+void Cache::writeLine(int address){
+    writebacks++;
+    if (next) next->acceptWriteback(address);
+    else if (memory) memory->transfer(true, blockSize);
+}
+
+// Absorb a line written back from the level above. Not a demand access:
+// hit/miss counters are untouched and the line is never fetched.
+void Cache::acceptWriteback(int address){
+    int blockNumber = address / blockSize;
+    int index = blockNumber % numSets;
+    int tag = blockNumber / numSets;
+
+    for (auto& line : sets[index]){
+        if (line.valid && line.tag == tag){
+            if (writeBack) line.dirty = true;
+            else writeLine(address);
+            return;
+        }
+    }
+
+    // Not present: install without fetch, or pass the line further down
+    if (!writeBack || !writeAllocate){
+        writeLine(address);
+        return;
+    }
+
+    globalTime++;
+    CacheLine* victim = selectVictim(index);
     victim->valid = true;
+    victim->dirty = true;
     victim->tag = tag;
     victim->insertedAt = globalTime;
     victim->lastUsed = globalTime;
     victim->frequency = 1;
-    return false;
+}
+
+// Propagate a store (write-through or no-write-allocate miss)
+void Cache::writeWord(int address){
+    writeThroughs++;
+    if (next) next->access(address, AccessType::WRITE);
+    else if (memory) memory->transfer(true, WORD_SIZE);
+}
+
+// Access a batch of addresses; bit i of hitBitmap is set when addresses[i] hit
+size_t Cache::accessBatch(const int* addresses, size_t count, unsigned char* hitBitmap){
+    const size_t PREFETCH_DISTANCE = 8;
+    size_t batchHits = 0;
+
+    for (size_t i = 0; i < count; i++){
+#if defined(__GNUC__)
+        // Pull set metadata for an upcoming address into cache
+        if (i + PREFETCH_DISTANCE < count){
+            int ahead = (addresses[i + PREFETCH_DISTANCE] / blockSize) % numSets;
+            __builtin_prefetch(sets[ahead].data());
+        }
+#endif
+        bool hit = access(addresses[i]);
+        batchHits += hit;
+
+        if (hitBitmap){
+            unsigned char mask = 1u << (i % 8);
+            if (hit) hitBitmap[i / 8] |= mask;
+            else hitBitmap[i / 8] &= ~mask;
+        }
+    }
+    return batchHits;
 }
 
 // Set cache replacement policy
@@ -84,18 +204,46 @@ bool Cache::setPolicy(std::string policyName){
 
 // Invalidate cache lines overlapping memory range
 void Cache::invalidateRange(int start, int size){
-    int end = start + size;
+    invalidateRanges({{start, size}});
+}
+
+// Set write-hit policy
+bool Cache::setWritePolicy(std::string policyName){
+    if (policyName == "write_back") writeBack = true;
+    else if (policyName == "write_through") writeBack = false;
+    else return false;
+    return true;
+}
+
+// Set write-miss policy
+bool Cache::setAllocatePolicy(std::string policyName){
+    if (policyName == "write_allocate") writeAllocate = true;
+    else if (policyName == "no_write_allocate") writeAllocate = false;
+    else return false;
+    return true;
+}
+
+// Invalidate cache lines overlapping any of the ranges in one pass over the sets
+// (dirty lines are written back first)
+void Cache::invalidateRanges(const std::vector<std::pair<int,int>>& ranges){
     for (int i = 0; i < numSets; i++){
         for (int j = 0; j < associativity; j++){
             if (!sets[i][j].valid) continue;
             int blockStart = (sets[i][j].tag * numSets + i) * blockSize;
             int BlockEnd = blockStart + blockSize;
 
-            if (blockStart < end && BlockEnd > start) sets[i][j].valid = false;
+            for (auto& [start, size] : ranges){
+                if (blockStart < start + size && BlockEnd > start){
+                    if (sets[i][j].dirty) writeLine(blockStart);
+                    sets[i][j].valid = false;
+                    sets[i][j].dirty = false;
+                    break;
+                }
+            }
         }
     }
 
-    if (next) next->invalidateRange(start, size);
+    if (next) next->invalidateRanges(ranges);
 }
 
 // Print cache statistics
@@ -105,6 +253,11 @@ void Cache::stats(int level){
     std::cout << "Hits          : " << hits << '\n';
     std::cout << "Misses        : " << misses<< '\n';
     std::cout << "Hit Ratio     : " << (hits + misses ? (double)hits/(hits + misses) : 0.0) << '\n';
+    std::cout << "Write policy  : " << (writeBack ? "write_back" : "write_through") << ", "
+              << (writeAllocate ? "write_allocate" : "no_write_allocate") << '\n';
+    std::cout << "Writes        : " << writes << '\n';
+    std::cout << "Writebacks    : " << writebacks << '\n';
+    std::cout << "Write-throughs: " << writeThroughs << '\n';
 
     if (next) {
         std::cout << "Misses propagated to L" << level+1 << " : " << misses << '\n';
@@ -112,4 +265,107 @@ void Cache::stats(int level){
     } else {
         std::cout << "Misses propagated to Memory : " << misses << '\n';
     }
-}
\ No newline at end of file
+}
+
+// Hit / miss counters of this level
+void Cache::getCounters(long long& hitCount, long long& missCount) const{
+    hitCount = hits;
+    missCount = misses;
+}
+
+Cache* Cache::nextLevel() const{
+    return next;
+}
+
+// Serialize cache state, then lower levels
+void Cache::save(SnapshotWriter& out) const{
+    out.put<int32_t>(cacheSize);
+    out.put<int32_t>(blockSize);
+    out.put<int32_t>(associativity);
+    out.put<int32_t>(static_cast<int32_t>(policy));
+    out.put<int64_t>(globalTime);
+    out.put<int64_t>(hits);
+    out.put<int64_t>(misses);
+    out.put<uint8_t>(writeBack);
+    out.put<uint8_t>(writeAllocate);
+    out.put<int64_t>(writes);
+    out.put<int64_t>(writebacks);
+    out.put<int64_t>(writeThroughs);
+
+    // Lines and policy metadata, field by field (no struct padding)
+    for (const auto& set : sets){
+        for (const auto& line : set){
+            out.put<uint8_t>(line.valid);
+            out.put<uint8_t>(line.dirty);
+            out.put<int32_t>(line.tag);
+            out.put<int64_t>(line.lastUsed);
+            out.put<int64_t>(line.frequency);
+            out.put<int64_t>(line.insertedAt);
+        }
+    }
+
+    if (next) next->save(out);
+}
+
+// Restore cache state (geometry included), then lower levels
+bool Cache::load(SnapshotReader& in){
+    int32_t size, block, assoc, policyId;
+    int64_t time, hitCount, missCount;
+    if (!in.get(size) || !in.get(block) || !in.get(assoc) || !in.get(policyId) ||
+        !in.get(time) || !in.get(hitCount) || !in.get(missCount))
+        return false;
+
+    uint8_t backMode, allocateMode;
+    int64_t writeCount, writebackCount, throughCount;
+    if (!in.get(backMode) || !in.get(allocateMode) || !in.get(writeCount) ||
+        !in.get(writebackCount) || !in.get(throughCount))
+        return false;
+    if (!validCacheConfig(size, block, assoc)) return false;
+    if (policyId < 0 || policyId > static_cast<int32_t>(ReplacementPolicy::LFU)) return false;
+    if (backMode > 1 || allocateMode > 1 || time < 0 || hitCount < 0 || missCount < 0) return false;
+
+    int blocks = size / block;
+    int setCount = blocks / assoc;
+    const size_t lineBytes = 2 * sizeof(uint8_t) + sizeof(int32_t) + 3 * sizeof(int64_t);
+    if ((size_t)blocks * lineBytes > in.remaining()) return false;
+
+    std::vector<std::vector<CacheLine>> restored(setCount, std::vector<CacheLine>(assoc));
+    for (auto& set : restored){
+        for (auto& line : set){
+            uint8_t valid, dirty;
+            int32_t tag;
+            int64_t lastUsed, frequency, insertedAt;
+            if (!in.get(valid) || !in.get(dirty) || !in.get(tag) ||
+                !in.get(lastUsed) || !in.get(frequency) || !in.get(insertedAt))
+                return false;
+
+            // Only valid lines can be dirty; a dirty line is written back on eviction
+            if (valid > 1 || dirty > 1 || (dirty && !valid) || tag < 0) return false;
+            line.valid = valid != 0;
+            line.dirty = dirty != 0;
+            line.tag = tag;
+            line.lastUsed = lastUsed;
+            line.frequency = frequency;
+            line.insertedAt = insertedAt;
+        }
+    }
+
+    if (next && !next->load(in)) return false;
+
+    cacheSize = size;
+    blockSize = block;
+    associativity = assoc;
+    numBlocks = blocks;
+    numSets = setCount;
+    policy = static_cast<ReplacementPolicy>(policyId);
+    globalTime = time;
+    hits = hitCount;
+    misses = missCount;
+    writeBack = backMode != 0;
+    writeAllocate = allocateMode != 0;
+    writes = writeCount;
+    writebacks = writebackCount;
+    writeThroughs = throughCount;
+    sets = std::move(restored);
+    return true;
+}
@@ -1,8 +1,11 @@
+#include <iomanip>
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <vector>
 #include "memsys.h"
 #include "cache.h"
+#include "trace.h"
 
 // -------- Helpers --------
 int readIntOrDefault(const std::string& msg, int def) {
@@ -24,29 +27,6 @@ std::string readStringOrDefault(const std::string& msg, const std::string& def)
     return line.empty() ? def : line;
 }
 
-bool isPowerOfTwo(int x) {
-    return x > 0 && (x & (x - 1)) == 0;
-}
-
-bool validCacheConfig(int cacheSize, int blockSize, int associativity) {
-    if (cacheSize <= 0 || blockSize <= 0 || associativity <= 0) 
-        return false;
-
-    if (cacheSize % blockSize != 0)
-        return false;
-
-    int numBlocks = cacheSize / blockSize;
-    if (numBlocks % associativity != 0)
-        return false;
-
-    if (!isPowerOfTwo(cacheSize) ||
-        !isPowerOfTwo(blockSize) ||
-        !isPowerOfTwo(associativity))
-        return false;
-
-    return true;
-}
-
 void printCacheConfigRules() {
     std::cout <<
     "Cache configuration rules:\n"
@@ -67,7 +47,7 @@ void initSystem(Memory*& mem, Cache*& L1, Cache*& L2) {
         }
 
         std::string allocType = readStringOrDefault(
-            "Enter allocator (first_fit / best_fit / worst_fit / buddy)",
+            "Enter allocator (first_fit / best_fit / worst_fit / buddy / tlsf / slab)",
             "first_fit"
         );
 
@@ -134,6 +114,146 @@ void initSystem(Memory*& mem, Cache*& L1, Cache*& L2) {
     }
 }
 
+// -------- Snapshots --------
+bool saveSystem(const std::string& path, Memory* mem, Cache* L1) {
+    SnapshotWriter out;
+    mem->save(out);
+    L1->save(out);
+    return saveSnapshotFile(path, out);
+}
+
+// Build a new hierarchy from snapshot payload (current one is untouched)
+bool restoreSystem(const std::string& payload, Memory*& mem, Cache*& L1, Cache*& L2) {
+    Memory* newMem = new Memory(1);
+    Cache* newL2 = new Cache(1, 1, 1, nullptr, newMem);
+    Cache* newL1 = new Cache(1, 1, 1, newL2, nullptr);
+
+    SnapshotReader in(payload);
+    if (!newMem->load(in) || !newL1->load(in) || in.remaining() != 0) {
+        delete newL1;
+        delete newL2;
+        delete newMem;
+        return false;
+    }
+
+    mem = newMem;
+    L1 = newL1;
+    L2 = newL2;
+    return true;
+}
+
+bool loadSystem(const std::string& path, Memory*& mem, Cache*& L1, Cache*& L2) {
+    std::string payload;
+    Memory* newMem;
+    Cache* newL1;
+    Cache* newL2;
+    if (!loadSnapshotFile(path, payload) || !restoreSystem(payload, newMem, newL1, newL2))
+        return false;
+
+    delete L1;
+    delete L2;
+    delete mem;
+
+    mem = newMem;
+    L1 = newL1;
+    L2 = newL2;
+    return true;
+}
+
+// -------- Fused comparison --------
+// Replays one trace against copies of the current system that differ only
+// in cache policy or allocator, then prints one row per variant.
+void compareVariants(const std::string& path, const std::string& target,
+                     const std::vector<std::string>& variants, Memory* mem, Cache* L1, Cache* L2) {
+    // Allocator variants share the live block list, so the live system must use one
+    if (target == "memory" && !mem->isListAllocator()) {
+        std::cout << "Memory comparison requires the current allocator to be first_fit, best_fit or worst_fit\n";
+        return;
+    }
+
+    std::vector<TraceEvent> events;
+    int badLines;
+    if (!loadTrace(path, events, badLines)) {
+        std::cout << "Cannot open trace " << path << '\n';
+        return;
+    }
+
+    SnapshotWriter out;
+    mem->save(out);
+    L1->save(out);
+
+    std::vector<ReplayTarget> targets;
+    std::vector<Cache*> lowerLevels;
+    bool ok = true;
+    for (const auto& variant : variants) {
+        ReplayTarget t;
+        Cache* l2;
+        t.name = variant;
+        if (!restoreSystem(out.data(), t.mem, t.L1, l2)) {
+            std::cout << "Failed to clone current system\n";
+            ok = false;
+            break;
+        }
+
+        if (target == "cache")
+            ok = t.L1->setPolicy(variant) && l2->setPolicy(variant);
+        else
+            ok = variant != "buddy" && variant != "tlsf" && variant != "slab" && t.mem->setAllocator(variant);
+
+        targets.push_back(std::move(t));
+        lowerLevels.push_back(l2);
+        if (!ok) {
+            std::cout << "Invalid " << target << " variant " << variant << '\n';
+            break;
+        }
+    }
+
+    if (ok) {
+        replayFused(events, targets);
+
+        long long baseHits1, baseMisses1, baseHits2, baseMisses2;
+        long long baseRead, baseWritten;
+        L1->getCounters(baseHits1, baseMisses1);
+        L2->getCounters(baseHits2, baseMisses2);
+        mem->getTraffic(baseRead, baseWritten);
+
+        std::cout << "Replayed " << events.size() << " events against " << targets.size() << " variants\n";
+        if (badLines)
+            std::cout << "Skipped " << badLines << " malformed line(s)\n";
+
+        std::cout << std::left << std::setw(12) << "Variant"
+                  << std::right << std::setw(10) << "L1 hits" << std::setw(10) << "L1 miss" << std::setw(10) << "L1 ratio"
+                  << std::setw(10) << "L2 hits" << std::setw(10) << "L2 miss" << std::setw(10) << "L2 ratio"
+                  << std::setw(12) << "Mem read" << std::setw(12) << "Mem write"
+                  << std::setw(14) << "Failed alloc" << '\n';
+
+        for (size_t i = 0; i < targets.size(); i++) {
+            long long h1, m1, h2, m2;
+            long long readBytes, writeBytes;
+            targets[i].L1->getCounters(h1, m1);
+            lowerLevels[i]->getCounters(h2, m2);
+            targets[i].mem->getTraffic(readBytes, writeBytes);
+            h1 -= baseHits1; m1 -= baseMisses1;
+            h2 -= baseHits2; m2 -= baseMisses2;
+
+            std::cout << std::left << std::setw(12) << targets[i].name << std::right
+                      << std::setw(10) << h1 << std::setw(10) << m1
+                      << std::setw(10) << std::fixed << std::setprecision(4) << (h1 + m1 ? (double)h1/(h1 + m1) : 0.0)
+                      << std::setw(10) << h2 << std::setw(10) << m2
+                      << std::setw(10) << (h2 + m2 ? (double)h2/(h2 + m2) : 0.0)
+                      << std::defaultfloat << std::setprecision(6)
+                      << std::setw(12) << readBytes - baseRead << std::setw(12) << writeBytes - baseWritten
+                      << std::setw(14) << targets[i].stats.failedAllocs << '\n';
+        }
+    }
+
+    for (size_t i = 0; i < targets.size(); i++) {
+        delete targets[i].L1;
+        delete lowerLevels[i];
+        delete targets[i].mem;
+    }
+}
+
 // -------- Main --------
 int main() {
    
@@ -169,8 +289,8 @@ int main() {
                     std::cout << "Cache policy set to " << policy << '\n';
             }
             else if (target == "memory") {
-                if (policy == "buddy") {
-                    std::cout << "Buddy allocator can only be set at startup\n";
+                if (policy == "buddy" || policy == "tlsf" || policy == "slab") {
+                    std::cout << "Allocator " << policy << " can only be set at startup\n";
                 }
                 else if (!mem->setAllocator(policy)) {
                     std::cout << "Invalid allocator\n";
@@ -179,8 +299,29 @@ int main() {
                     std::cout << "Memory allocator set to " << policy << '\n';
                 }
             }
+            else if (target == "compaction") {
+                if (policy != "on" && policy != "off")
+                    std::cout << "Usage: set compaction on|off\n";
+                else if (!mem->setCompaction(policy == "on"))
+                    std::cout << "Compaction requires first_fit, best_fit or worst_fit\n";
+                else
+                    std::cout << "Compaction " << policy << '\n';
+            }
+            else if (target == "write" || target == "alloc") {
+                // Per level: set write|alloc L1|L2 POLICY
+                std::string level = policy;
+                ss >> policy;
+
+                Cache* cache = level == "L1" ? L1 : level == "L2" ? L2 : nullptr;
+                bool ok = cache && (target == "write" ? cache->setWritePolicy(policy) : cache->setAllocatePolicy(policy));
+                if (!ok)
+                    std::cout << "Usage: set write L1|L2 write_back|write_through\n"
+                                 "       set alloc L1|L2 write_allocate|no_write_allocate\n";
+                else
+                    std::cout << level << " " << target << " policy set to " << policy << '\n';
+            }
             else {
-                std::cout << "Usage: set cache|memory POLICY\n";
+                std::cout << "Usage: set cache|memory|compaction|write|alloc POLICY\n";
             }
         }
 
@@ -193,16 +334,16 @@ int main() {
                 continue;
             }
 
-            int id = mem->malloc(size);
+            int relocated;
+            int id = syncedMalloc(mem, L1, size, relocated);
 
-            if (id == -1) {
+            if (relocated)
+                std::cout << "Heap compacted, " << relocated << " block(s) relocated\n";
+
+            if (id == -1)
                 std::cout << "Allocation failed\n";
-            } else {
-                int start, sz;
-                if (mem->getLastAllocation(start, sz))
-                    L1->invalidateRange(start, sz);
+            else
                 std::cout << "Allocated block id = " << id << '\n';
-            }
         }
 
         // ---- Free ----
@@ -222,7 +363,15 @@ int main() {
         // ---- Access ----
         else if (cmd == "access") {
             int address; ss >> address;
-            std::cout << (L1->access(address) ? "Cache hit\n" : "Cache miss\n");
+            std::string kind = "r";
+            ss >> kind;
+
+            if (kind != "r" && kind != "w") {
+                std::cout << "Usage: access ADDRESS [r|w]\n";
+                continue;
+            }
+            Cache::AccessType type = kind == "w" ? Cache::AccessType::WRITE : Cache::AccessType::READ;
+            std::cout << (L1->access(address, type) ? "Cache hit\n" : "Cache miss\n");
         }
 
         // ---- Stats ----
@@ -231,6 +380,69 @@ int main() {
             L1->stats(1);
         }
 
+        // ---- Trace replay ----
+        else if (cmd == "replay") {
+            std::string path; ss >> path;
+            std::vector<TraceEvent> events;
+            int badLines;
+
+            if (path.empty()) {
+                std::cout << "Usage: replay FILE\n";
+                continue;
+            }
+            if (!loadTrace(path, events, badLines)) {
+                std::cout << "Cannot open trace " << path << '\n';
+                continue;
+            }
+
+            ReplayStats rs;
+            replayTrace(events, mem, L1, rs);
+
+            std::cout << "Replayed " << events.size() << " events"
+                      << " (" << rs.mallocs << " malloc, " << rs.frees << " free, "
+                      << rs.accesses << " access, " << rs.writes << " write)\n";
+            std::cout << "Failed allocations : " << rs.failedAllocs << '\n';
+            std::cout << "Unmatched frees    : " << rs.unknownFrees << '\n';
+            if (rs.accesses)
+                std::cout << "L1 hits            : " << rs.hits << '\n';
+            if (badLines)
+                std::cout << "Skipped " << badLines << " malformed line(s)\n";
+        }
+
+        // ---- Fused multi-variant replay ----
+        else if (cmd == "compare") {
+            std::string path, target, variant;
+            std::vector<std::string> variants;
+            ss >> path >> target;
+            while (ss >> variant) variants.push_back(variant);
+
+            if (path.empty() || (target != "cache" && target != "memory") || variants.empty())
+                std::cout << "Usage: compare FILE cache|memory POLICY...\n";
+            else
+                compareVariants(path, target, variants, mem, L1, L2);
+        }
+
+        // ---- Snapshot ----
+        else if (cmd == "save") {
+            std::string path; ss >> path;
+            if (path.empty())
+                std::cout << "Usage: save FILE\n";
+            else if (saveSystem(path, mem, L1))
+                std::cout << "Snapshot saved to " << path << '\n';
+            else
+                std::cout << "Failed to write snapshot\n";
+        }
+
+        else if (cmd == "load") {
+            std::string path; ss >> path;
+            if (path.empty())
+                std::cout << "Usage: load FILE\n";
+            else if (loadSystem(path, mem, L1, L2))
+                std::cout << "Snapshot restored from " << path << '\n';
+            else
+                std::cout << "Invalid or unreadable snapshot\n";
+        }
+
         // ---- Reinitialise system ----
         else if (cmd == "reinit") {
             std::cout << "Reinitializing system...\n";
@@ -252,11 +464,19 @@ int main() {
             "Available commands:\n"
             "  malloc SIZE              Allocate memory block\n"
             "  free ID                  Free allocated block\n"
-            "  access ADDRESS           Access memory address (cache lookup)\n"
+            "  access ADDRESS [r|w]     Read (default) or write memory address\n"
             "  dump                     Dump memory layout\n"
             "  stats                    Show memory and cache statistics\n"
             "  set cache POLICY         Change cache replacement policy\n"
             "  set memory POLICY        Change memory allocation strategy\n"
+            "  set compaction on|off    Compact heap when a fit fails\n"
+            "  set write L1|L2 POLICY   write_back / write_through\n"
+            "  set alloc L1|L2 POLICY   write_allocate / no_write_allocate\n"
+            "  replay FILE              Replay a malloc/free/access trace\n"
+            "  compare FILE cache|memory POLICY...\n"
+            "                           Replay trace once per policy in one pass\n"
+            "  save FILE                Save full simulator state\n"
+            "  load FILE                Restore simulator state from snapshot\n"
             "  reinit                   Reinitialize system (full restart)\n"
             "  exit                     Exit simulator\n"
             "\n"
@@ -265,6 +485,8 @@ int main() {
             "  best_fit\n"
             "  worst_fit\n"
             "  buddy        (startup only)\n"
+            "  tlsf         (startup only)\n"
+            "  slab         (startup only)\n"
             "\n"
             "Cache replacement policies:\n"
             "  fifo\n"
@@ -0,0 +1,138 @@
+#include "memsim_c.h"
+#include <unordered_map>
+#include "memsys.h"
+#include "cache.h"
+#include "trace.h"
+
+// Opaque handle behind the C API
+struct memsim{
+    Memory* mem;
+    Cache* L1;
+    Cache* L2;
+    std::unordered_map<uint64_t,int> handles;      // caller handle -> block id
+};
+
+static void setBit(uint8_t* bitmap, size_t i, bool value){
+    if (!bitmap) return;
+    uint8_t mask = 1u << (i % 8);
+    if (value) bitmap[i / 8] |= mask;
+    else bitmap[i / 8] &= ~mask;
+}
+
+int memsim_api_version(void){
+    return MEMSIM_API_VERSION;
+}
+
+// Same defaults as the interactive simulator
+void memsim_default_config(memsim_config* config){
+    config->memory_size = 1024;
+    config->allocator = "first_fit";
+    config->l1_size = 64;  config->l1_block = 16; config->l1_assoc = 2;
+    config->l2_size = 256; config->l2_block = 16; config->l2_assoc = 4;
+    config->policy = "fifo";
+}
+
+memsim* memsim_create(const memsim_config* config){
+    if (!config || config->memory_size <= 0) return nullptr;
+    if (!validCacheConfig(config->l1_size, config->l1_block, config->l1_assoc) ||
+        !validCacheConfig(config->l2_size, config->l2_block, config->l2_assoc))
+        return nullptr;
+    if (!(config->l1_size < config->l2_size && config->l2_size < config->memory_size)) return nullptr;
+
+    std::string allocator = config->allocator ? config->allocator : "first_fit";
+    std::string policy = config->policy ? config->policy : "fifo";
+    if (allocator == "buddy" && !isPowerOfTwo(config->memory_size)) return nullptr;
+
+    memsim* sim = new memsim;
+    sim->mem = new Memory(config->memory_size);
+    sim->L2 = new Cache(config->l2_size, config->l2_block, config->l2_assoc, nullptr, sim->mem);
+    sim->L1 = new Cache(config->l1_size, config->l1_block, config->l1_assoc, sim->L2, nullptr);
+
+    if (!sim->mem->setAllocator(allocator) || !sim->L1->setPolicy(policy) || !sim->L2->setPolicy(policy)){
+        memsim_destroy(sim);
+        return nullptr;
+    }
+    return sim;
+}
+
+void memsim_destroy(memsim* sim){
+    if (!sim) return;
+    delete sim->L1;
+    delete sim->L2;
+    delete sim->mem;
+    delete sim;
+}
+
+int memsim_set_write_policy(memsim* sim, int level, int write_back, int write_allocate){
+    Cache* cache = sim->L1;
+    for (int i = 1; cache && i < level; i++) cache = cache->nextLevel();
+    if (!cache || level < 1) return 0;
+
+    cache->setWritePolicy(write_back ? "write_back" : "write_through");
+    cache->setAllocatePolicy(write_allocate ? "write_allocate" : "no_write_allocate");
+    return 1;
+}
+
+int memsim_malloc(memsim* sim, int size){
+    int relocated;
+    return syncedMalloc(sim->mem, sim->L1, size, relocated);
+}
+
+int memsim_free(memsim* sim, int id){
+    return sim->mem->free(id) ? 1 : 0;
+}
+
+size_t memsim_access_batch(memsim* sim, const int* addresses, size_t count, uint8_t* hit_bitmap){
+    return sim->L1->accessBatch(addresses, count, hit_bitmap);
+}
+
+size_t memsim_replay_events(memsim* sim, const memsim_event* events, size_t count, uint8_t* result_bitmap){
+    size_t ok = 0;
+    for (size_t i = 0; i < count; i++){
+        const memsim_event& ev = events[i];
+        bool result = false;
+
+        if (ev.type == MEMSIM_MALLOC){
+            int relocated;
+            int id = syncedMalloc(sim->mem, sim->L1, ev.value, relocated);
+            result = id != -1;
+            if (result) sim->handles[ev.handle] = id;
+            else sim->handles.erase(ev.handle);
+        } else if (ev.type == MEMSIM_FREE){
+            auto it = sim->handles.find(ev.handle);
+            if (it != sim->handles.end()){
+                result = sim->mem->free(it->second);
+                sim->handles.erase(it);
+            }
+        } else if (ev.type == MEMSIM_ACCESS){
+            result = sim->L1->access(ev.value);
+        } else if (ev.type == MEMSIM_WRITE){
+            result = sim->L1->access(ev.value, Cache::AccessType::WRITE);
+        }
+
+        setBit(result_bitmap, i, result);
+        ok += result;
+    }
+    return ok;
+}
+
+void memsim_memory_traffic(const memsim* sim, int64_t* read_bytes, int64_t* write_bytes){
+    long long read, written;
+    sim->mem->getTraffic(read, written);
+    if (read_bytes) *read_bytes = read;
+    if (write_bytes) *write_bytes = written;
+}
+
+int memsim_counters(const memsim* sim, memsim_level_counters* out, int max_levels){
+    int levels = 0;
+    for (Cache* level = sim->L1; level; level = level->nextLevel()){
+        if (out && levels < max_levels){
+            long long hits, misses;
+            level->getCounters(hits, misses);
+            out[levels].hits = hits;
+            out[levels].misses = misses;
+        }
+        levels++;
+    }
+    return levels;
+}
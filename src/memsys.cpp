@@ -1,6 +1,7 @@
 #include "memsys.h"
 #include <iostream>
 #include <algorithm>
+#include <unordered_set>
 
 // Memory block representation
 struct Memory::Block{
@@ -94,6 +95,49 @@ int Memory::mallocWF(int need){
     return worst ? allocate(worst, need) : -1;
 }
 
+// Dispatch list-based allocation
+int Memory::mallocFit(int need){
+    if (allocator == AllocatorType::FIRST_FIT) return mallocFF(need);
+    if (allocator == AllocatorType::BEST_FIT) return mallocBF(need);
+    return mallocWF(need);
+}
+
+// Slide used blocks toward address 0 and merge all free space at the end
+void Memory::compact(){
+    compactions++;
+
+    int cursor = 0;
+    Block* cur = head, *prev = nullptr;
+    while (cur){
+        if (cur->free){
+            Block* tmp = cur;
+            cur = cur->next;
+            if (prev) prev->next = cur;
+            else head = cur;
+            delete tmp;
+            continue;
+        }
+
+        if (cur->start != cursor){
+            lastRelocations.push_back({cur->id, cur->start, cursor, cur->size});
+            bytesRelocated += cur->size;
+
+            // Copy cost: block is read from its old range and written to the new one
+            readBytes += cur->size;
+            writeBytes += cur->size;
+            cur->start = cursor;
+        }
+        cursor += cur->size;
+        prev = cur; cur = cur->next;
+    }
+
+    if (cursor < totalMemory){
+        Block* tail = new Block(cursor, totalMemory - cursor, -1, true, nullptr);
+        if (prev) prev->next = tail;
+        else head = tail;
+    }
+}
+
 // Initialize memory and buddy system
 Memory::Memory(int size) : totalMemory(size), nextId(1), lastAllocStart(-1), lastAllocSize(0), allocator(AllocatorType::FIRST_FIT) {
     head = new Block(0, size, -1, true, nullptr);
@@ -103,6 +147,41 @@ Memory::Memory(int size) : totalMemory(size), nextId(1), lastAllocStart(-1), las
 
     freeLists.resize(maxOrder+1);
     freeLists[maxOrder].push_back(0);
+
+    // TLSF: whole memory starts as one free block
+    tlsfFlBitmap = 0;
+    tlsfSlBitmap.assign(TLSF_FL_COUNT, 0);
+    tlsfHeads.assign(TLSF_FL_COUNT, std::vector<int>(1 << TLSF_SL_LOG2, -1));
+    tlsfBlocks[0] = {size, -1, -1, -1, -1, true};
+    tlsfInsert(0);
+
+    // Slab: power-of-two pages (a quarter of memory, capped at 4 KiB), classes 8..page
+    slabPageSize = 8;
+    while (slabPageSize * 2 <= size / 4 && slabPageSize < 4096) slabPageSize <<= 1;
+    for (int cls = 8; cls <= slabPageSize; cls <<= 1) slabClasses.push_back(cls);
+    slabPartial.assign(slabClasses.size(), -1);
+
+    int pages = size / slabPageSize;
+    slabPageClass.assign(pages, -1);
+    slabPageInUse.assign(pages, 0);
+    slabPageFree.resize(pages);
+    slabPrev.assign(pages, -1);
+    slabNext.assign(pages, -1);
+    slabFreeHead = -1;
+    for (int page = pages - 1; page >= 0; page--) slabLink(slabFreeHead, page);
+}
+
+// Release block list
+Memory::~Memory(){
+    clearBlocks();
+}
+
+void Memory::clearBlocks(){
+    while (head){
+        Block* tmp = head;
+        head = head->next;
+        delete tmp;
+    }
 }
 
 // Set allocation strategy
@@ -111,10 +190,18 @@ bool Memory::setAllocator(std::string type){
     else if (type == "best_fit") allocator = AllocatorType::BEST_FIT;
     else if (type == "worst_fit") allocator = AllocatorType::WORST_FIT;
     else if (type == "buddy") allocator = AllocatorType::BUDDY; 
+    else if (type == "tlsf") allocator = AllocatorType::TLSF;
+    else if (type == "slab") allocator = AllocatorType::SLAB;
     else return false;
     return true;
 }
 
+// Block-list allocators can be switched at runtime; the others keep separate state
+bool Memory::isListAllocator() const{
+    return allocator == AllocatorType::FIRST_FIT || allocator == AllocatorType::BEST_FIT
+        || allocator == AllocatorType::WORST_FIT;
+}
+
 // Allocate memory
 int Memory::malloc(int size){
     if (size <= 0) return -1;
@@ -122,11 +209,22 @@ int Memory::malloc(int size){
     totalAllocs++;
     lastAllocStart = -1;
 
+    lastRelocations.clear();
+
     int id;
     if (allocator == AllocatorType::BUDDY) id = buddyMalloc(size);
-    else if (allocator == AllocatorType::FIRST_FIT) id = mallocFF(size);
-    else if (allocator == AllocatorType::BEST_FIT) id = mallocBF(size);
-    else id = mallocWF(size);
+    else if (allocator == AllocatorType::TLSF) id = tlsfMalloc(size);
+    else if (allocator == AllocatorType::SLAB) id = slabMalloc(size);
+    else {
+        id = mallocFit(size);
+
+        // Retry once after compaction if enough memory is free in total
+        if (id == -1 && compaction && totalMemory - usedMemory >= size){
+            compact();
+            id = mallocFit(size);
+            if (id != -1) compactionRecovered++;
+        }
+    }
 
     if (id == -1) failedAllocs++;
     return id;
@@ -135,15 +233,17 @@ int Memory::malloc(int size){
 // Free allocated memory
 bool Memory::free(int id){
     if (allocator == AllocatorType::BUDDY) return buddyFree(id);
+    if (allocator == AllocatorType::TLSF) return tlsfFree(id);
+    if (allocator == AllocatorType::SLAB) return slabFree(id);
 
     Block* cur = head, *prev = nullptr;
     while (cur){
         if (!cur->free && cur->id == id){
+            usedMemory -= cur->size;        // Before merging grows or deletes cur
+
             cur->makeFree();
             if (cur->next && cur->next->free) cur->mergeNext();
             if (prev && prev->free) prev->mergeNext();
-
-            usedMemory -= cur->size;
             return true;
         }
         prev = cur; cur = cur->next;
@@ -158,6 +258,17 @@ bool Memory::access(int address){
     return true;
 }
 
+// Record traffic between the last cache level and memory
+void Memory::transfer(bool write, int bytes){
+    if (write) writeBytes += bytes;
+    else readBytes += bytes;
+}
+
+void Memory::getTraffic(long long& read, long long& written) const{
+    read = readBytes;
+    written = writeBytes;
+}
+
 // Fetch last allocation info
 bool Memory::getLastAllocation(int& start, int&size){
     if (lastAllocStart == -1) return false;
@@ -166,6 +277,41 @@ bool Memory::getLastAllocation(int& start, int&size){
     return true;
 }
 
+// Enable compaction (list allocators only)
+bool Memory::setCompaction(bool enabled){
+    if (enabled && (allocator == AllocatorType::BUDDY || allocator == AllocatorType::TLSF || allocator == AllocatorType::SLAB))
+        return false;
+    compaction = enabled;
+    return true;
+}
+
+// Blocks that malloc(size) will relocate, without changing any state; lets the
+// caller write back cached data of the source ranges before the copy
+bool Memory::planCompaction(int size, std::vector<Relocation>& moves) const{
+    moves.clear();
+    if (!isListAllocator() || !compaction || size <= 0 || totalMemory - usedMemory < size) return false;
+
+    // Compaction only runs when no single free block fits
+    for (Block* cur = head; cur; cur = cur->next){
+        if (cur->free && cur->size >= size) return false;
+    }
+
+    int cursor = 0;
+    for (Block* cur = head; cur; cur = cur->next){
+        if (cur->free) continue;
+        if (cur->start != cursor) moves.push_back({cur->id, cur->start, cursor, cur->size});
+        cursor += cur->size;
+    }
+    return !moves.empty();
+}
+
+// Fetch blocks relocated by the last allocation
+bool Memory::getLastRelocations(std::vector<Relocation>& moved){
+    if (lastRelocations.empty()) return false;
+    moved = lastRelocations;
+    return true;
+}
+
 // Print memory layout
 void Memory::dump(){
     if (allocator == AllocatorType::BUDDY){
@@ -203,6 +349,47 @@ void Memory::dump(){
             }
             std::cout << std::dec << '\n';
         }
+    } else if (allocator == AllocatorType::TLSF){
+        for (int start = 0; start < totalMemory; start += tlsfBlocks[start].size){
+            const TlsfBlock& block = tlsfBlocks[start];
+            std::cout << "[0x" << std::hex << start << " - 0x"
+            << (start + block.size - 1) << "] ";
+            if (block.free) std::cout << "FREE" << '\n';
+            else std::cout << "Used (id=" << std::dec << block.id << ")" << '\n';
+        }
+        std::cout << std::dec;
+    } else if (allocator == AllocatorType::SLAB){
+        for (int page = 0; page < (int)slabPageClass.size(); page++){
+            int start = page * slabPageSize;
+            std::cout << "[0x" << std::hex << start << " - 0x"
+            << (start + slabPageSize - 1) << "] " << std::dec;
+            if (slabPageClass[page] == -1) std::cout << "FREE page" << '\n';
+            else if (slabPageClass[page] == SLAB_LARGE) std::cout << "Large object page" << '\n';
+            else std::cout << "Slab (class=" << slabClasses[slabPageClass[page]]
+                           << ", used=" << slabPageInUse[page]
+                           << "/" << slabPageSize / slabClasses[slabPageClass[page]] << ")\n";
+        }
+
+        // Objects in address order
+        std::vector<std::pair<int,int>> objects;
+        for (auto& [id, info] : slabAllocated) objects.push_back({info.first, id});
+        std::sort(objects.begin(), objects.end());
+
+        std::cout << "\nAllocated objects:\n";
+        if (objects.empty()) std::cout << "  (none)\n";
+        for (auto& [start, id] : objects){
+            const auto& info = slabAllocated[id];
+            int cls = slabPageClass[info.first / slabPageSize];
+            int size = cls == SLAB_LARGE
+                ? (info.second + slabPageSize - 1) / slabPageSize * slabPageSize
+                : slabClasses[cls];
+            std::cout << "  [0x" << std::hex << info.first
+                    << " - 0x" << (info.first + size - 1) << "] "
+                    << "Used (id=" << std::dec << id;
+            if (cls == SLAB_LARGE) std::cout << ", pages=" << size / slabPageSize;
+            else std::cout << ", class=" << size;
+            std::cout << ", req=" << info.second << ")\n";
+        }
     } else {
         Block* cur = head;
         while (cur){
@@ -276,13 +463,285 @@ bool Memory::buddyFree(int id){
     return true;
 }
 
+// Map block size to its TLSF (first-level, second-level) list
+void Memory::tlsfMapping(int size, int& fl, int& sl){
+    if (size < (1 << TLSF_SL_LOG2)){
+        fl = 0;
+        sl = size;
+    } else {
+        int msb = 31 - __builtin_clz(size);
+        fl = msb - TLSF_SL_LOG2 + 1;
+        sl = (size >> (msb - TLSF_SL_LOG2)) - (1 << TLSF_SL_LOG2);
+    }
+}
+
+// Push free block at the head of its list
+void Memory::tlsfInsert(int start){
+    TlsfBlock& block = tlsfBlocks[start];
+    int fl, sl;
+    tlsfMapping(block.size, fl, sl);
+
+    int head = tlsfHeads[fl][sl];
+    block.prevFree = -1;
+    block.nextFree = head;
+    if (head != -1) tlsfBlocks[head].prevFree = start;
+    tlsfHeads[fl][sl] = start;
+
+    tlsfFlBitmap |= 1u << fl;
+    tlsfSlBitmap[fl] |= 1u << sl;
+}
+
+// Unlink free block from its list
+void Memory::tlsfRemove(int start){
+    TlsfBlock& block = tlsfBlocks[start];
+    int fl, sl;
+    tlsfMapping(block.size, fl, sl);
+
+    if (block.prevFree != -1) tlsfBlocks[block.prevFree].nextFree = block.nextFree;
+    else tlsfHeads[fl][sl] = block.nextFree;
+    if (block.nextFree != -1) tlsfBlocks[block.nextFree].prevFree = block.prevFree;
+
+    if (tlsfHeads[fl][sl] == -1){
+        tlsfSlBitmap[fl] &= ~(1u << sl);
+        if (!tlsfSlBitmap[fl]) tlsfFlBitmap &= ~(1u << fl);
+    }
+}
+
+// TLSF allocation: two bitmap lookups, no list traversal
+int Memory::tlsfMalloc(int size){
+    if (size > totalMemory) return -1;
+
+    // Round up so any block in the chosen list is large enough
+    int search = size;
+    if (search >= (1 << TLSF_SL_LOG2)){
+        int msb = 31 - __builtin_clz(search);
+        search += (1 << (msb - TLSF_SL_LOG2)) - 1;
+    }
+
+    int fl, sl;
+    tlsfMapping(search, fl, sl);
+    if (fl >= TLSF_FL_COUNT) return -1;
+
+    unsigned int slMap = tlsfSlBitmap[fl] & (~0u << sl);
+    if (!slMap){
+        unsigned int flMap = fl + 1 < TLSF_FL_COUNT ? tlsfFlBitmap & (~0u << (fl + 1)) : 0;
+        if (!flMap) return -1;
+        fl = __builtin_ctz(flMap);
+        slMap = tlsfSlBitmap[fl];
+    }
+    sl = __builtin_ctz(slMap);
+
+    int start = tlsfHeads[fl][sl];
+    tlsfRemove(start);
+    TlsfBlock& block = tlsfBlocks[start];
+
+    // Split remainder back into the free lists
+    if (block.size > size){
+        int rest = start + size;
+        int restSize = block.size - size;
+        block.size = size;
+
+        int after = rest + restSize;
+        if (after < totalMemory) tlsfBlocks[after].prevPhys = rest;
+
+        tlsfBlocks[rest] = {restSize, -1, start, -1, -1, true};
+        tlsfInsert(rest);
+    }
+
+    int id = nextId++;
+    block.free = false;
+    block.id = id;
+    tlsfAllocated[id] = start;
+
+    lastAllocStart = start;
+    lastAllocSize = size;
+    usedMemory += size;
+    return id;
+}
+
+// TLSF deallocation with immediate coalescing of physical neighbours
+bool Memory::tlsfFree(int id){
+    auto it = tlsfAllocated.find(id);
+    if (it == tlsfAllocated.end()) return false;
+
+    int start = it->second;
+    tlsfAllocated.erase(it);
+
+    TlsfBlock* block = &tlsfBlocks[start];
+    usedMemory -= block->size;
+    block->free = true;
+    block->id = -1;
+
+    // Merge with next physical block
+    int after = start + block->size;
+    if (after < totalMemory && tlsfBlocks[after].free){
+        tlsfRemove(after);
+        block->size += tlsfBlocks[after].size;
+        tlsfBlocks.erase(after);
+
+        int nextStart = start + block->size;
+        if (nextStart < totalMemory) tlsfBlocks[nextStart].prevPhys = start;
+    }
+
+    // Merge with previous physical block
+    int before = block->prevPhys;
+    if (before != -1 && tlsfBlocks[before].free){
+        tlsfRemove(before);
+        tlsfBlocks[before].size += block->size;
+        tlsfBlocks.erase(start);
+        start = before;
+
+        int nextStart = start + tlsfBlocks[start].size;
+        if (nextStart < totalMemory) tlsfBlocks[nextStart].prevPhys = start;
+    }
+
+    tlsfInsert(start);
+    return true;
+}
+
+// Push page at the head of a page list
+void Memory::slabLink(int& head, int page){
+    slabPrev[page] = -1;
+    slabNext[page] = head;
+    if (head != -1) slabPrev[head] = page;
+    head = page;
+}
+
+// Unlink page from a page list
+void Memory::slabUnlink(int& head, int page){
+    if (slabPrev[page] != -1) slabNext[slabPrev[page]] = slabNext[page];
+    else head = slabNext[page];
+    if (slabNext[page] != -1) slabPrev[slabNext[page]] = slabPrev[page];
+    slabPrev[page] = slabNext[page] = -1;
+}
+
+// Slab allocation: smallest size class that fits, first page with a free object
+int Memory::slabMalloc(int size){
+    if (size > slabPageSize) return slabMallocLarge(size);
+
+    int cls = 0;
+    while (slabClasses[cls] < size) cls++;
+    int objSize = slabClasses[cls];
+
+    // Carve a fresh page into objects of this class
+    int page = slabPartial[cls];
+    if (page == -1){
+        if (slabFreeHead == -1) return -1;
+        page = slabFreeHead;
+        slabUnlink(slabFreeHead, page);
+        slabPageClass[page] = cls;
+
+        int base = page * slabPageSize;
+        for (int off = slabPageSize - objSize; off >= 0; off -= objSize){
+            slabPageFree[page].push_back(base + off);
+        }
+        slabLink(slabPartial[cls], page);
+    }
+
+    auto& freeObjects = slabPageFree[page];
+    int start = freeObjects.back();
+    freeObjects.pop_back();
+    slabPageInUse[page]++;
+    if (freeObjects.empty()) slabUnlink(slabPartial[cls], page);
+
+    int id = nextId++;
+    slabAllocated[id] = {start, size};
+
+    lastAllocStart = start;
+    lastAllocSize = objSize;
+    usedMemory += objSize;
+    internalFrag += objSize - size;
+    return id;
+}
+
+// Large slab allocation: first run of contiguous free pages
+int Memory::slabMallocLarge(int size){
+    int pages = slabPageClass.size();
+    int need = (size + slabPageSize - 1) / slabPageSize;
+    if (need > pages) return -1;
+
+    int first = -1;
+    for (int page = 0, run = 0; page < pages; page++){
+        run = slabPageClass[page] == -1 ? run + 1 : 0;
+        if (run == need){
+            first = page - need + 1;
+            break;
+        }
+    }
+    if (first == -1) return -1;
+
+    for (int page = first; page < first + need; page++){
+        slabUnlink(slabFreeHead, page);
+        slabPageClass[page] = SLAB_LARGE;
+    }
+
+    int start = first * slabPageSize;
+    int allocSize = need * slabPageSize;
+
+    int id = nextId++;
+    slabAllocated[id] = {start, size};
+
+    lastAllocStart = start;
+    lastAllocSize = allocSize;
+    usedMemory += allocSize;
+    internalFrag += allocSize - size;
+    return id;
+}
+
+// Slab deallocation; empty pages are returned to the page pool
+bool Memory::slabFree(int id){
+    auto it = slabAllocated.find(id);
+    if (it == slabAllocated.end()) return false;
+
+    int start = it->second.first, req = it->second.second;
+    slabAllocated.erase(it);
+
+    int page = start / slabPageSize;
+
+    // Large object: release its whole page run
+    if (slabPageClass[page] == SLAB_LARGE){
+        int need = (req + slabPageSize - 1) / slabPageSize;
+        for (int p = page; p < page + need; p++){
+            slabPageClass[p] = -1;
+            slabLink(slabFreeHead, p);
+        }
+        usedMemory -= need * slabPageSize;
+        internalFrag -= need * slabPageSize - req;
+        return true;
+    }
+    int cls = slabPageClass[page];
+    int objSize = slabClasses[cls];
+    auto& freeObjects = slabPageFree[page];
+
+    usedMemory -= objSize;
+    internalFrag -= objSize - req;
+
+    // Full page regains a free object
+    if (freeObjects.empty()) slabLink(slabPartial[cls], page);
+    freeObjects.push_back(start);
+
+    if (--slabPageInUse[page] == 0){
+        freeObjects.clear();
+        slabUnlink(slabPartial[cls], page);
+        slabPageClass[page] = -1;
+        slabLink(slabFreeHead, page);
+    }
+    return true;
+}
+
 // Print memory statistics
 void Memory::stats(){
     std::cout << "==== Memory Statistics ====" << '\n';
 
+    // Slab cannot use the tail past the last whole page
+    int capacity = totalMemory;
+    if (allocator == AllocatorType::SLAB) capacity = slabPageClass.size() * slabPageSize;
+
     std::cout << "Total memory           : " << totalMemory << '\n';
     std::cout << "Used memory            : " << usedMemory << '\n';
-    std::cout << "Free memory            : " << totalMemory - usedMemory << '\n';
+    std::cout << "Free memory            : " << capacity - usedMemory << '\n';
+    if (capacity != totalMemory)
+        std::cout << "Unusable memory        : " << totalMemory - capacity << '\n';
     std::cout << "Memory Utilization     : " << (double)usedMemory/totalMemory << '\n';
 
     
@@ -291,6 +750,25 @@ void Memory::stats(){
         for (int order = 0; order <= maxOrder; order++){
             if (freeLists[order].size()) largestFree = std::max(largestFree, (1 << order));
         }
+    } else if (allocator == AllocatorType::TLSF){
+        // Highest non-empty list holds the largest block
+        if (tlsfFlBitmap){
+            int fl = 31 - __builtin_clz(tlsfFlBitmap);
+            int sl = 31 - __builtin_clz(tlsfSlBitmap[fl]);
+            for (int cur = tlsfHeads[fl][sl]; cur != -1; cur = tlsfBlocks[cur].nextFree){
+                largestFree = std::max(largestFree, tlsfBlocks[cur].size);
+            }
+        }
+    } else if (allocator == AllocatorType::SLAB){
+        // Longest run of unassigned pages, else largest class with a free object
+        int run = 0;
+        for (int page = 0; page < (int)slabPageClass.size(); page++){
+            run = slabPageClass[page] == -1 ? run + 1 : 0;
+            largestFree = std::max(largestFree, run * slabPageSize);
+        }
+        for (int cls = 0; cls < (int)slabClasses.size(); cls++){
+            if (slabPartial[cls] != -1) largestFree = std::max(largestFree, slabClasses[cls]);
+        }
     } else {
         Block* cur = head;
         while (cur){
@@ -300,11 +778,401 @@ void Memory::stats(){
     }
     
     std::cout << "Internal fragmentation : " << (usedMemory ?  (double)internalFrag/usedMemory : 0.0) << '\n'; 
-    std::cout << "External fragmentation : " << (totalMemory == usedMemory ? 0.0 : 1 - (double)largestFree/(totalMemory - usedMemory)) << '\n'; 
+    std::cout << "External fragmentation : " << (capacity == usedMemory ? 0.0 : 1 - (double)largestFree/(capacity - usedMemory)) << '\n'; 
 
     std::cout << "Total allocations      : " << totalAllocs << '\n';
     std::cout << "Successful allocations : " << totalAllocs - failedAllocs << '\n';
     std::cout << "Failed allocations     : " << failedAllocs << '\n';
     std::cout << "Success rate           : " << (totalAllocs ?  1 - (double)failedAllocs/totalAllocs : 0.0)<< '\n'; 
     std::cout << "Failed rate            : " << (totalAllocs ? (double)failedAllocs/totalAllocs : 0.0) << '\n'; 
+    std::cout << "Read traffic (bytes)   : " << readBytes << '\n';
+    std::cout << "Write traffic (bytes)  : " << writeBytes << '\n';
+
+    if (compaction || compactions){
+        std::cout << "Compactions            : " << compactions << '\n';
+        std::cout << "Recovered allocations  : " << compactionRecovered << '\n';
+        std::cout << "Bytes relocated        : " << bytesRelocated << '\n';
+        std::cout << "Copy traffic (bytes)   : " << 2LL * bytesRelocated << " (included in read/write traffic)\n";
+    }
+}
+
+// Serialize full memory state
+void Memory::save(SnapshotWriter& out) const{
+    out.put<int32_t>(totalMemory);
+    out.put<int32_t>(nextId);
+    out.put<int32_t>(lastAllocStart);
+    out.put<int32_t>(lastAllocSize);
+    out.put<int32_t>(static_cast<int32_t>(allocator));
+    out.put<int32_t>(totalAllocs);
+    out.put<int32_t>(failedAllocs);
+    out.put<int32_t>(usedMemory);
+    out.put<int32_t>(internalFrag);
+    out.put<int64_t>(readBytes);
+    out.put<int64_t>(writeBytes);
+    out.put<uint8_t>(compaction);
+    out.put<int32_t>(compactions);
+    out.put<int32_t>(compactionRecovered);
+    out.put<int32_t>(bytesRelocated);
+
+    // Block list
+    int32_t count = 0;
+    for (Block* cur = head; cur; cur = cur->next) count++;
+    out.put<int32_t>(count);
+    for (Block* cur = head; cur; cur = cur->next){
+        out.put<int32_t>(cur->start);
+        out.put<int32_t>(cur->size);
+        out.put<int32_t>(cur->id);
+        out.put<uint8_t>(cur->free);
+    }
+
+    // Buddy free lists
+    out.put<int32_t>(maxOrder);
+    for (const auto& list : freeLists) out.putVector(list);
+
+    // Buddy allocations
+    out.put<int32_t>(buddyAllocated.size());
+    for (const auto& [start, info] : buddyAllocated){
+        out.put<int32_t>(start);
+        out.put<int32_t>(info.first);
+        out.put<int32_t>(info.second);
+    }
+
+    // TLSF blocks, lists and bitmaps
+    out.put<int32_t>(tlsfBlocks.size());
+    for (const auto& [start, block] : tlsfBlocks){
+        out.put<int32_t>(start);
+        out.put<int32_t>(block.size);
+        out.put<int32_t>(block.id);
+        out.put<int32_t>(block.prevPhys);
+        out.put<int32_t>(block.prevFree);
+        out.put<int32_t>(block.nextFree);
+        out.put<uint8_t>(block.free);
+    }
+    out.put(tlsfFlBitmap);
+    out.putVector(tlsfSlBitmap);
+    for (const auto& row : tlsfHeads) out.putVector(row);
+
+    // Slab pages, per-page free objects and page lists in list order
+    auto pageList = [&](int head){
+        std::vector<int> list;
+        for (int page = head; page != -1; page = slabNext[page]) list.push_back(page);
+        return list;
+    };
+    out.put<int32_t>(slabPageSize);
+    out.putVector(slabClasses);
+    out.putVector(slabPageClass);
+    out.putVector(slabPageInUse);
+    for (const auto& list : slabPageFree) out.putVector(list);
+    out.putVector(pageList(slabFreeHead));
+    for (int head : slabPartial) out.putVector(pageList(head));
+    out.put<int32_t>(slabAllocated.size());
+    for (const auto& [id, info] : slabAllocated){
+        out.put<int32_t>(id);
+        out.put<int32_t>(info.first);
+        out.put<int32_t>(info.second);
+    }
+}
+
+// Restore full memory state (replaces current contents)
+bool Memory::load(SnapshotReader& in){
+    int32_t total, id, allocStart, allocSize, type, allocs, failed, used, frag;
+    if (!in.get(total) || !in.get(id) || !in.get(allocStart) || !in.get(allocSize) || !in.get(type) ||
+        !in.get(allocs) || !in.get(failed) || !in.get(used) || !in.get(frag))
+        return false;
+
+    int64_t trafficRead, trafficWritten;
+    if (!in.get(trafficRead) || !in.get(trafficWritten)) return false;
+
+    uint8_t compactMode;
+    int32_t compactCount, recovered, relocated;
+    if (!in.get(compactMode) || !in.get(compactCount) || !in.get(recovered) || !in.get(relocated))
+        return false;
+    if (total <= 0 || id <= 0 || type < 0 || type > static_cast<int32_t>(AllocatorType::SLAB)) return false;
+
+    // Live ids are handed out below nextId
+    auto validId = [&](int32_t value){ return value > 0 && value < id; };
+
+    // Block list must tile [0, total); free blocks carry no id
+    struct BlockRecord{ int32_t start, size, id; uint8_t free; };
+    int32_t count;
+    if (!in.get(count) || count <= 0 || (size_t)count > in.remaining()) return false;
+
+    std::vector<BlockRecord> blocks(count);
+    std::unordered_set<int> listIds;
+    long long expectedStart = 0;
+    for (auto& b : blocks){
+        if (!in.get(b.start) || !in.get(b.size) || !in.get(b.id) || !in.get(b.free)) return false;
+        if (b.start != expectedStart || b.size <= 0 || b.free > 1) return false;
+        if (b.free ? b.id != -1 : !validId(b.id) || !listIds.insert(b.id).second) return false;
+        expectedStart += b.size;
+    }
+    if (expectedStart != total) return false;
+
+    // Buddy free lists
+    int32_t order, expectedOrder = 0;
+    while ((1LL << expectedOrder) < total) expectedOrder++;
+    if (!in.get(order) || order != expectedOrder || order > 30) return false;
+
+    // Free and allocated buddy blocks must be aligned and tile [0, 2^order)
+    std::vector<std::pair<int,int>> spans;
+    auto alignedSpan = [&](int32_t start, int32_t blockOrder){
+        if (blockOrder < 0 || blockOrder > order || start < 0) return false;
+        long long length = 1LL << blockOrder;
+        if (start % length != 0 || start + length > (1LL << order)) return false;
+        spans.push_back({start, (int)length});
+        return true;
+    };
+
+    std::vector<std::vector<int>> lists(order + 1);
+    for (int32_t o = 0; o <= order; o++){
+        if (!in.getVector(lists[o])) return false;
+        for (int start : lists[o]){
+            if (!alignedSpan(start, o)) return false;
+        }
+    }
+
+    // Buddy allocations
+    int32_t n;
+    if (!in.get(n) || n < 0 || (size_t)n > in.remaining()) return false;
+
+    std::unordered_map<int,std::pair<int,int>> allocated;
+    for (int32_t i = 0; i < n; i++){
+        int32_t start, blockOrder, req;
+        if (!in.get(start) || !in.get(blockOrder) || !in.get(req)) return false;
+        if (!alignedSpan(start, blockOrder) || req <= 0 || req > (1LL << blockOrder)) return false;
+        if (!allocated.insert({start, {blockOrder, req}}).second) return false;
+    }
+
+    std::sort(spans.begin(), spans.end());
+    long long buddyEnd = 0;
+    for (auto& [start, length] : spans){
+        if (start != buddyEnd) return false;
+        buddyEnd += length;
+    }
+    if (buddyEnd != (1LL << order)) return false;
+
+    // TLSF blocks
+    int32_t tlsfCount;
+    if (!in.get(tlsfCount) || tlsfCount <= 0 || (size_t)tlsfCount > in.remaining()) return false;
+
+    std::unordered_map<int,TlsfBlock> tlsf;
+    std::unordered_map<int,int> tlsfIds;
+    size_t tlsfFree = 0;
+    for (int32_t i = 0; i < tlsfCount; i++){
+        int32_t start;
+        TlsfBlock block;
+        uint8_t isFree;
+        if (!in.get(start) || !in.get(block.size) || !in.get(block.id) || !in.get(block.prevPhys) ||
+            !in.get(block.prevFree) || !in.get(block.nextFree) || !in.get(isFree))
+            return false;
+        if (block.size <= 0 || isFree > 1 || !tlsf.insert({start, block}).second) return false;
+
+        tlsf[start].free = isFree != 0;
+        if (isFree){
+            if (block.id != -1) return false;
+            tlsfFree++;
+        } else if (!validId(block.id) || !tlsfIds.insert({block.id, start}).second){
+            return false;
+        }
+    }
+
+    // Physical blocks must tile [0, total) with correct back links
+    long long pos = 0;
+    int prevStart = -1;
+    size_t visited = 0;
+    while (pos < total){
+        auto it = tlsf.find(pos);
+        if (it == tlsf.end() || it->second.prevPhys != prevStart) return false;
+        prevStart = pos;
+        pos += it->second.size;
+        visited++;
+    }
+    if (pos != total || visited != tlsf.size()) return false;
+
+    unsigned int flBitmap;
+    std::vector<unsigned int> slBitmap;
+    std::vector<std::vector<int>> heads(TLSF_FL_COUNT);
+    if (!in.get(flBitmap) || !in.getVector(slBitmap) || slBitmap.size() != TLSF_FL_COUNT) return false;
+    for (auto& row : heads){
+        if (!in.getVector(row) || row.size() != (1 << TLSF_SL_LOG2)) return false;
+    }
+
+    // Every free block sits in the list its size maps to; bitmaps mirror the heads
+    size_t listed = 0;
+    unsigned int expectedFl = 0;
+    for (int fl = 0; fl < TLSF_FL_COUNT; fl++){
+        unsigned int expectedSl = 0;
+        for (int sl = 0; sl < (1 << TLSF_SL_LOG2); sl++){
+            int prevFree = -1;
+            for (int cur = heads[fl][sl]; cur != -1; ){
+                auto it = tlsf.find(cur);
+                if (it == tlsf.end() || !it->second.free || it->second.prevFree != prevFree || ++listed > tlsfFree)
+                    return false;
+
+                int blockFl, blockSl;
+                tlsfMapping(it->second.size, blockFl, blockSl);
+                if (blockFl != fl || blockSl != sl) return false;
+                prevFree = cur;
+                cur = it->second.nextFree;
+            }
+            if (heads[fl][sl] != -1) expectedSl |= 1u << sl;
+        }
+        if (slBitmap[fl] != expectedSl) return false;
+        if (expectedSl) expectedFl |= 1u << fl;
+    }
+    if (flBitmap != expectedFl || listed != tlsfFree) return false;
+
+    // Slab geometry is derived from the memory size
+    int32_t pageSize;
+    std::vector<int> classes, freePages, pageClass, pageInUse;
+    std::vector<std::vector<int>> pageFree, partial;
+    if (!in.get(pageSize) || !in.getVector(classes)) return false;
+
+    int expectedPage = 8;
+    while (expectedPage * 2 <= total / 4 && expectedPage < 4096) expectedPage <<= 1;
+    std::vector<int> expectedClasses;
+    for (int cls = 8; cls <= expectedPage; cls <<= 1) expectedClasses.push_back(cls);
+    if (pageSize != expectedPage || classes != expectedClasses) return false;
+
+    int classCount = classes.size();
+    int pages = total / pageSize;
+    if (!in.getVector(pageClass) || !in.getVector(pageInUse)) return false;
+    if ((int)pageClass.size() != pages || (int)pageInUse.size() != pages) return false;
+
+    int unassigned = 0;
+    for (int page = 0; page < pages; page++){
+        int cls = pageClass[page];
+        if (cls < SLAB_LARGE || cls >= classCount) return false;
+        if (cls == -1) unassigned++;
+        if (cls < 0 ? pageInUse[page] != 0 : pageInUse[page] <= 0 || pageInUse[page] > pageSize / classes[cls])
+            return false;
+    }
+
+    pageFree.resize(pages);
+    for (auto& list : pageFree){
+        if (!in.getVector(list)) return false;
+    }
+
+    // Each page is on at most one list: the pool holds every unassigned page,
+    // a class list every page of that class with a free object
+    std::vector<char> onList(pages, 0);
+    auto validList = [&](const std::vector<int>& list, int cls){
+        for (int page : list){
+            if (page < 0 || page >= pages || onList[page] || pageClass[page] != cls) return false;
+            if (cls >= 0 && pageFree[page].empty()) return false;
+            onList[page] = 1;
+        }
+        return true;
+    };
+    if (!in.getVector(freePages) || !validList(freePages, -1) || (int)freePages.size() != unassigned) return false;
+
+    partial.resize(classCount);
+    for (int cls = 0; cls < classCount; cls++){
+        if (!in.getVector(partial[cls]) || !validList(partial[cls], cls)) return false;
+    }
+
+    // Objects of a class live on pages of that class, once each
+    std::unordered_set<int> objects;
+    std::vector<int> pageObjects(pages, 0), pageLive(pages, 0);
+    auto claimObject = [&](int start, int cls){
+        if (start < 0 || start >= pages * pageSize) return false;
+        int page = start / pageSize;
+        if (pageClass[page] != cls || (start % pageSize) % classes[cls] != 0) return false;
+        if (!objects.insert(start).second) return false;
+        pageObjects[page]++;
+        return true;
+    };
+    for (int page = 0; page < pages; page++){
+        for (int start : pageFree[page]){
+            if (start < 0 || start / pageSize != page || pageClass[page] < 0 || !claimObject(start, pageClass[page]))
+                return false;
+        }
+    }
+
+    int32_t slabCount;
+    if (!in.get(slabCount) || slabCount < 0 || (size_t)slabCount > in.remaining()) return false;
+
+    std::unordered_map<int,std::pair<int,int>> slabIds;
+    std::vector<char> largeOwned(pages, 0);
+    for (int32_t i = 0; i < slabCount; i++){
+        int32_t slabId, start, req;
+        if (!in.get(slabId) || !in.get(start) || !in.get(req)) return false;
+        if (!validId(slabId) || req <= 0 || start < 0 || start >= pages * pageSize) return false;
+        if (!slabIds.insert({slabId, {start, req}}).second) return false;
+
+        int page = start / pageSize;
+        int cls = pageClass[page];
+        if (cls == SLAB_LARGE){
+            // Large objects own a page-aligned run of large pages
+            int need = (req + pageSize - 1) / pageSize;
+            if (req <= pageSize || start % pageSize != 0 || need > pages - page) return false;
+            for (int p = page; p < page + need; p++){
+                if (pageClass[p] != SLAB_LARGE || largeOwned[p]) return false;
+                largeOwned[p] = 1;
+            }
+        } else if (cls < 0 || req > classes[cls] || !claimObject(start, cls)){
+            return false;
+        } else {
+            pageLive[page]++;
+        }
+    }
+
+    // Class pages are fully carved and count their live objects; no orphaned large pages
+    for (int page = 0; page < pages; page++){
+        int cls = pageClass[page];
+        if (cls == SLAB_LARGE && !largeOwned[page]) return false;
+        if (cls >= 0 && (pageLive[page] != pageInUse[page] || pageObjects[page] != pageSize / classes[cls] ||
+                         onList[page] != !pageFree[page].empty()))
+            return false;
+    }
+
+    // Commit restored state
+    clearBlocks();
+    for (int32_t i = count - 1; i >= 0; i--){
+        head = new Block(blocks[i].start, blocks[i].size, blocks[i].id, blocks[i].free != 0, head);
+    }
+
+    totalMemory = total;
+    nextId = id;
+    lastAllocStart = allocStart;
+    lastAllocSize = allocSize;
+    allocator = static_cast<AllocatorType>(type);
+    totalAllocs = allocs;
+    failedAllocs = failed;
+    usedMemory = used;
+    internalFrag = frag;
+    readBytes = trafficRead;
+    writeBytes = trafficWritten;
+    compaction = compactMode != 0;
+    compactions = compactCount;
+    compactionRecovered = recovered;
+    bytesRelocated = relocated;
+    lastRelocations.clear();
+    maxOrder = order;
+    freeLists = std::move(lists);
+    buddyAllocated = std::move(allocated);
+
+    tlsfBlocks = std::move(tlsf);
+    tlsfAllocated = std::move(tlsfIds);
+    tlsfFlBitmap = flBitmap;
+    tlsfSlBitmap = std::move(slBitmap);
+    tlsfHeads = std::move(heads);
+
+    slabPageSize = pageSize;
+    slabClasses = std::move(classes);
+    slabPageClass = std::move(pageClass);
+    slabPageInUse = std::move(pageInUse);
+    slabPageFree = std::move(pageFree);
+
+    // Rebuild page links in saved list order
+    slabPrev.assign(pages, -1);
+    slabNext.assign(pages, -1);
+    slabFreeHead = -1;
+    for (auto page = freePages.rbegin(); page != freePages.rend(); ++page) slabLink(slabFreeHead, *page);
+    slabPartial.assign(classCount, -1);
+    for (int cls = 0; cls < classCount; cls++){
+        for (auto page = partial[cls].rbegin(); page != partial[cls].rend(); ++page) slabLink(slabPartial[cls], *page);
+    }
+    slabAllocated = std::move(slabIds);
+    return true;
 }
\ No newline at end of file
@@ -0,0 +1,39 @@
+#include "snapshot.h"
+#include <fstream>
+
+// Snapshot file header
+static const char SNAPSHOT_MAGIC[8] = {'M', 'S', 'S', 'N', 'A', 'P', '\0', '\0'};
+static const uint32_t SNAPSHOT_VERSION = 7;
+
+// Write snapshot to disk in a single pass
+bool saveSnapshotFile(const std::string& path, const SnapshotWriter& writer){
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) return false;
+
+    out.write(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    out.write(reinterpret_cast<const char*>(&SNAPSHOT_VERSION), sizeof(SNAPSHOT_VERSION));
+    out.write(writer.data().data(), writer.data().size());
+    return (bool)out;
+}
+
+// Load whole snapshot with one bulk read and validate header
+bool loadSnapshotFile(const std::string& path, std::string& payload){
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) return false;
+
+    std::streamoff fileSize = in.tellg();
+    std::streamoff headerSize = sizeof(SNAPSHOT_MAGIC) + sizeof(SNAPSHOT_VERSION);
+    if (fileSize < headerSize) return false;
+    in.seekg(0);
+
+    char magic[sizeof(SNAPSHOT_MAGIC)];
+    uint32_t version = 0;
+    in.read(magic, sizeof(magic));
+    in.read(reinterpret_cast<char*>(&version), sizeof(version));
+    if (!in || std::memcmp(magic, SNAPSHOT_MAGIC, sizeof(magic)) != 0 || version != SNAPSHOT_VERSION)
+        return false;
+
+    payload.resize(fileSize - headerSize);
+    in.read(&payload[0], payload.size());
+    return (bool)in;
+}
@@ -0,0 +1,136 @@
+#include "trace.h"
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+
+// Parse trace file; events with sequence numbers are put back in global order
+bool loadTrace(const std::string& path, std::vector<TraceEvent>& events, int& badLines){
+    std::ifstream in(path);
+    if (!in) return false;
+
+    events.clear();
+    badLines = 0;
+
+    std::string line;
+    unsigned long long order = 0;
+    bool sequenced = false;
+    while (std::getline(in, line)){
+        std::stringstream ss(line);
+        std::string tok;
+        if (!(ss >> tok) || tok[0] == '#') continue;
+
+        TraceEvent ev;
+        ev.seq = order++;
+        ev.value = 0;
+
+        // Optional leading sequence number
+        if (std::isdigit((unsigned char)tok[0])){
+            try {
+                ev.seq = std::stoull(tok);
+            } catch (...) {
+                badLines++;
+                continue;
+            }
+            sequenced = true;
+            if (!(ss >> tok)) { badLines++; continue; }
+        }
+
+        bool ok;
+        if (tok == "m"){
+            ev.type = TraceEvent::Type::MALLOC;
+            long long size;
+            ok = (bool)(ss >> ev.handle >> size) && size > 0;
+            ev.value = (int)std::min<long long>(size, INT_MAX);
+        } else if (tok == "f"){
+            ev.type = TraceEvent::Type::FREE;
+            ok = (bool)(ss >> ev.handle);
+        } else if (tok == "a" || tok == "r" || tok == "w"){
+            ev.type = tok == "w" ? TraceEvent::Type::WRITE : TraceEvent::Type::ACCESS;
+            ok = (bool)(ss >> ev.value) && ev.value >= 0;
+        } else {
+            ok = false;
+        }
+
+        if (ok) events.push_back(std::move(ev));
+        else badLines++;
+    }
+
+    if (sequenced){
+        std::stable_sort(events.begin(), events.end(),
+            [](const TraceEvent& a, const TraceEvent& b){ return a.seq < b.seq; });
+    }
+    return true;
+}
+
+// Allocate and invalidate the allocated range plus any block moved by compaction
+int syncedMalloc(Memory* mem, Cache* L1, int size, int& relocated){
+    // Write back and drop lines of blocks about to move, so the copy reads current data
+    std::vector<Memory::Relocation> moving;
+    if (mem->planCompaction(size, moving)){
+        std::vector<std::pair<int,int>> ranges;
+        for (auto& r : moving)
+            ranges.push_back({r.newStart, r.oldStart + r.size - r.newStart});
+        L1->invalidateRanges(ranges);
+    }
+
+    int id = mem->malloc(size);
+
+    std::vector<Memory::Relocation> moved;
+    relocated = mem->getLastRelocations(moved) ? moved.size() : 0;
+
+    int start, sz;
+    if (id != -1 && mem->getLastAllocation(start, sz))
+        L1->invalidateRange(start, sz);
+    return id;
+}
+
+// Apply one event to a replay target
+void replayEvent(const TraceEvent& ev, ReplayTarget& target){
+    ReplayStats& stats = target.stats;
+
+    if (ev.type == TraceEvent::Type::MALLOC){
+        stats.mallocs++;
+        int relocated;
+        int id = syncedMalloc(target.mem, target.L1, ev.value, relocated);
+        if (id == -1) {
+            stats.failedAllocs++;
+            target.ids.erase(ev.handle);
+        } else {
+            target.ids[ev.handle] = id;
+        }
+    } else if (ev.type == TraceEvent::Type::FREE){
+        stats.frees++;
+        auto it = target.ids.find(ev.handle);
+        if (it == target.ids.end()) {
+            stats.unknownFrees++;       // Allocation failed in the simulator or predates the trace
+            return;
+        }
+        target.mem->free(it->second);
+        target.ids.erase(it);
+    } else {
+        bool isWrite = ev.type == TraceEvent::Type::WRITE;
+        stats.accesses++;
+        if (isWrite) stats.writes++;
+        if (target.L1->access(ev.value, isWrite ? Cache::AccessType::WRITE : Cache::AccessType::READ)) stats.hits++;
+    }
+}
+
+// Replay events against one memory + cache hierarchy
+void replayTrace(const std::vector<TraceEvent>& events, Memory* mem, Cache* L1, ReplayStats& stats){
+    ReplayTarget target;
+    target.mem = mem;
+    target.L1 = L1;
+
+    for (const auto& ev : events) replayEvent(ev, target);
+    stats = target.stats;
+}
+
+// Decode once, dispatch each event to every target while it is still hot
+void replayFused(const std::vector<TraceEvent>& events, std::vector<ReplayTarget>& targets){
+    for (const auto& ev : events){
+        for (auto& target : targets) replayEvent(ev, target);
+    }
+}
@@ -0,0 +1,393 @@
+// memtrace: LD_PRELOAD shim recording malloc/free/calloc/realloc, the
+// aligned allocators (posix_memalign, aligned_alloc, memalign, valloc,
+// pvalloc) and reallocarray as a MemSysSim trace (see include/trace.h).
+//
+// Build:  make memtrace
+// Use:    MEMTRACE_FILE=app.trace LD_PRELOAD=bin/libmemtrace.so ./app
+//
+// Every process image writes its own file, MEMTRACE_FILE.<pid>; an image
+// started by exec in a process that already has a file continues in
+// MEMTRACE_FILE.<pid>.1, .2, ... Existing files are never truncated, so
+// children inheriting LD_PRELOAD cannot clobber their parent's trace.
+//
+// Each thread formats records into its own buffer and flushes whole
+// buffers with a single O_APPEND write, so recording never contends on a
+// lock. A per-process atomic sequence number restores the cross-thread
+// order on replay; frees take their number before the real free and
+// allocations after the real malloc, so an address is never reused
+// "before" it was released. Buffers of threads still running at exit are
+// flushed by the destructor, and records made after it are written
+// unbuffered. A forked child also writes unbuffered, since an exec would
+// discard whatever it had buffered.
+
+#define _GNU_SOURCE
+#include <dlfcn.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define MEMTRACE_BUFFER_SIZE (64 * 1024)
+#define MEMTRACE_RECORD_MAX  64
+#define MEMTRACE_PATH_MAX    4096
+
+// Per-thread record buffer; busy is only contended by memtrace_fini
+struct thread_buffer{
+    atomic_flag busy;
+    size_t len;
+    struct thread_buffer* next;
+    char data[MEMTRACE_BUFFER_SIZE];
+};
+
+static void* (*real_malloc)(size_t);
+static void  (*real_free)(void*);
+static void* (*real_calloc)(size_t, size_t);
+static void* (*real_realloc)(void*, size_t);
+static int   (*real_posix_memalign)(void**, size_t, size_t);
+static void* (*real_aligned_alloc)(size_t, size_t);
+static void* (*real_memalign)(size_t, size_t);
+static void* (*real_valloc)(size_t);
+static void* (*real_pvalloc)(size_t);
+
+static int trace_fd = -1;
+static atomic_ullong next_seq;
+static atomic_int finished;
+static int unbuffered;              // forked child: exec would drop buffered records
+static pthread_key_t flush_key;
+static int resolving;
+
+// Buffers of live threads, walked by memtrace_fini
+static pthread_mutex_t threads_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct thread_buffer* threads;
+
+// Serves allocations made by dlsym while the real symbols are resolved
+static char bootstrap_arena[4096];
+static size_t bootstrap_used;
+
+static __thread struct thread_buffer tbuf;
+static __thread int registered;     // 0 = not yet, 1 = listed, 2 = exited (unbuffered)
+static __thread int in_hook;
+
+static void* bootstrap_alloc(size_t size){
+    size = (size + 15) & ~(size_t)15;
+    if (bootstrap_used + size > sizeof(bootstrap_arena)) return NULL;
+    void* p = bootstrap_arena + bootstrap_used;
+    bootstrap_used += size;
+    return p;
+}
+
+static int from_bootstrap(void* p){
+    return (char*)p >= bootstrap_arena && (char*)p < bootstrap_arena + sizeof(bootstrap_arena);
+}
+
+static void write_all(const char* data, size_t len){
+    size_t off = 0;
+    while (off < len){
+        ssize_t n = write(trace_fd, data + off, len - off);
+        if (n <= 0) break;
+        off += n;
+    }
+}
+
+static void flush_buffer(struct thread_buffer* b){
+    write_all(b->data, b->len);
+    b->len = 0;
+}
+
+static void lock_buffer(struct thread_buffer* b){
+    while (atomic_flag_test_and_set_explicit(&b->busy, memory_order_acquire)) {}
+}
+
+static void unlock_buffer(struct thread_buffer* b){
+    atomic_flag_clear_explicit(&b->busy, memory_order_release);
+}
+
+static char* put_dec(char* out, unsigned long long value);
+
+// Open a fresh MEMTRACE_FILE.<pid>[.<n>] without touching existing files
+static void open_trace(void){
+    const char* base = getenv("MEMTRACE_FILE");
+    if (!base) base = "memtrace.trace";
+    size_t baseLen = strlen(base);
+    if (baseLen + 48 > MEMTRACE_PATH_MAX) return;
+
+    char path[MEMTRACE_PATH_MAX];
+    memcpy(path, base, baseLen);
+    char* suffix = path + baseLen;
+    *suffix++ = '.';
+    suffix = put_dec(suffix, (unsigned long long)getpid());
+
+    for (unsigned n = 0; n < 1000 && trace_fd == -1; n++){
+        char* end = suffix;
+        if (n){
+            *end++ = '.';
+            end = put_dec(end, n);
+        }
+        *end = '\0';
+        trace_fd = open(path, O_WRONLY | O_CREAT | O_EXCL | O_APPEND, 0644);
+        if (trace_fd == -1 && errno != EEXIST) return;
+    }
+    if (trace_fd == -1) return;
+
+    char header[80] = "# memtrace 1 pid ";
+    char* out = header + strlen(header);
+    out = put_dec(out, (unsigned long long)getpid());
+    memcpy(out, " ppid ", 6);
+    out = put_dec(out + 6, (unsigned long long)getppid());
+    *out++ = '\n';
+    write_all(header, out - header);
+}
+
+static void flush_thread(void* unused){
+    (void)unused;
+    pthread_mutex_lock(&threads_lock);
+    for (struct thread_buffer** p = &threads; *p; p = &(*p)->next){
+        if (*p == &tbuf){
+            *p = tbuf.next;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&threads_lock);
+
+    lock_buffer(&tbuf);
+    if (trace_fd != -1) flush_buffer(&tbuf);
+    unlock_buffer(&tbuf);
+    registered = 2;
+}
+
+static void register_thread(void){
+    registered = 1;
+    pthread_mutex_lock(&threads_lock);
+    tbuf.next = threads;
+    threads = &tbuf;
+    pthread_mutex_unlock(&threads_lock);
+    pthread_setspecific(flush_key, (void*)1);
+}
+
+// Keep the thread list consistent across fork
+static void before_fork(void){
+    pthread_mutex_lock(&threads_lock);
+}
+
+static void after_fork_parent(void){
+    pthread_mutex_unlock(&threads_lock);
+}
+
+// The child has only the forking thread: drop the copied records and
+// sequence numbers of the parent and start a trace file of its own
+static void after_fork_child(void){
+    unbuffered = 1;
+    threads = NULL;
+    if (registered == 1){
+        tbuf.next = NULL;
+        threads = &tbuf;
+    }
+    tbuf.len = 0;
+    unlock_buffer(&tbuf);
+    pthread_mutex_unlock(&threads_lock);
+
+    if (trace_fd != -1) close(trace_fd);
+    trace_fd = -1;
+    atomic_store(&next_seq, 0);
+    if (!atomic_load(&finished)) open_trace();
+}
+
+static void resolve(void){
+    resolving = 1;
+    real_malloc  = dlsym(RTLD_NEXT, "malloc");
+    real_free    = dlsym(RTLD_NEXT, "free");
+    real_calloc  = dlsym(RTLD_NEXT, "calloc");
+    real_realloc = dlsym(RTLD_NEXT, "realloc");
+    real_posix_memalign = dlsym(RTLD_NEXT, "posix_memalign");
+    real_aligned_alloc  = dlsym(RTLD_NEXT, "aligned_alloc");
+    real_memalign       = dlsym(RTLD_NEXT, "memalign");
+    real_valloc         = dlsym(RTLD_NEXT, "valloc");
+    real_pvalloc        = dlsym(RTLD_NEXT, "pvalloc");
+    resolving = 0;
+
+    open_trace();
+    pthread_key_create(&flush_key, flush_thread);
+    pthread_atfork(before_fork, after_fork_parent, after_fork_child);
+}
+
+__attribute__((constructor)) static void memtrace_init(void){
+    if (!real_malloc) resolve();
+}
+
+// Flush every live thread's buffer; later records bypass the buffers.
+// The file stays open for allocations made by other exit handlers.
+__attribute__((destructor)) static void memtrace_fini(void){
+    atomic_store(&finished, 1);
+    if (trace_fd == -1) return;
+
+    pthread_mutex_lock(&threads_lock);
+    for (struct thread_buffer* b = threads; b; b = b->next){
+        lock_buffer(b);
+        flush_buffer(b);
+        unlock_buffer(b);
+    }
+    pthread_mutex_unlock(&threads_lock);
+}
+
+static char* put_dec(char* out, unsigned long long value){
+    char tmp[24];
+    int n = 0;
+    do { tmp[n++] = '0' + value % 10; value /= 10; } while (value);
+    while (n) *out++ = tmp[--n];
+    return out;
+}
+
+static char* put_hex(char* out, unsigned long long value){
+    static const char digits[] = "0123456789abcdef";
+    char tmp[20];
+    int n = 0;
+    do { tmp[n++] = digits[value & 15]; value >>= 4; } while (value);
+    *out++ = '0'; *out++ = 'x';
+    while (n) *out++ = tmp[--n];
+    return out;
+}
+
+// Append "SEQ OP PTR [SIZE]\n" to the calling thread's buffer
+static void record(unsigned long long seq, char op, void* ptr, size_t size){
+    if (trace_fd == -1) return;
+    if (!registered) register_thread();
+
+    char line[MEMTRACE_RECORD_MAX];
+    char* out = put_dec(line, seq);
+    *out++ = ' '; *out++ = op; *out++ = ' ';
+    out = put_hex(out, (uintptr_t)ptr);
+    if (op == 'm'){
+        *out++ = ' ';
+        out = put_dec(out, size);
+    }
+    *out++ = '\n';
+    size_t len = out - line;
+
+    if (registered == 2 || unbuffered){
+        write_all(line, len);
+        return;
+    }
+
+    lock_buffer(&tbuf);
+    if (atomic_load(&finished)){
+        flush_buffer(&tbuf);
+        write_all(line, len);
+    } else {
+        if (tbuf.len + len > MEMTRACE_BUFFER_SIZE) flush_buffer(&tbuf);
+        memcpy(tbuf.data + tbuf.len, line, len);
+        tbuf.len += len;
+    }
+    unlock_buffer(&tbuf);
+}
+
+static unsigned long long take_seq(void){
+    return atomic_fetch_add_explicit(&next_seq, 1, memory_order_relaxed);
+}
+
+// Record a successful allocation made by any of the hooks
+static void* traced_alloc(void* p, size_t size){
+    if (p && !in_hook){
+        in_hook = 1;
+        record(take_seq(), 'm', p, size);
+        in_hook = 0;
+    }
+    return p;
+}
+
+void* malloc(size_t size){
+    if (!real_malloc){
+        if (resolving) return bootstrap_alloc(size);
+        resolve();
+    }
+    return traced_alloc(real_malloc(size), size);
+}
+
+void free(void* p){
+    if (!p || from_bootstrap(p)) return;
+    if (!real_free) resolve();
+    if (!in_hook){
+        in_hook = 1;
+        record(take_seq(), 'f', p, 0);
+        in_hook = 0;
+    }
+    real_free(p);
+}
+
+void* calloc(size_t count, size_t size){
+    if (!real_calloc){
+        if (resolving){
+            void* p = bootstrap_alloc(count * size);
+            if (p) memset(p, 0, count * size);
+            return p;
+        }
+        resolve();
+    }
+    return traced_alloc(real_calloc(count, size), count * size);
+}
+
+void* realloc(void* old, size_t size){
+    if (!real_realloc){
+        if (resolving) return NULL;
+        resolve();
+    }
+    if (old && from_bootstrap(old)){
+        size_t avail = bootstrap_arena + sizeof(bootstrap_arena) - (char*)old;
+        void* p = malloc(size);
+        if (p) memcpy(p, old, size < avail ? size : avail);
+        return p;
+    }
+
+    // Modeled as free(old) followed by malloc(size)
+    unsigned long long freeSeq = 0;
+    if (old && !in_hook) freeSeq = take_seq();
+
+    void* p = real_realloc(old, size);
+    if (!in_hook){
+        in_hook = 1;
+        if (old && (p || size == 0)) record(freeSeq, 'f', old, 0);
+        if (p) record(take_seq(), 'm', p, size);
+        in_hook = 0;
+    }
+    return p;
+}
+
+// Overflow-checked realloc; recorded through the realloc hook
+void* reallocarray(void* old, size_t count, size_t size){
+    if (size && count > SIZE_MAX / size){
+        errno = ENOMEM;
+        return NULL;
+    }
+    return realloc(old, count * size);
+}
+
+// Aligned allocations are recorded with the requested size, like malloc
+int posix_memalign(void** out, size_t alignment, size_t size){
+    if (!real_posix_memalign) resolve();
+    int err = real_posix_memalign(out, alignment, size);
+    if (!err) traced_alloc(*out, size);
+    return err;
+}
+
+void* aligned_alloc(size_t alignment, size_t size){
+    if (!real_aligned_alloc) resolve();
+    return traced_alloc(real_aligned_alloc(alignment, size), size);
+}
+
+void* memalign(size_t alignment, size_t size){
+    if (!real_memalign) resolve();
+    return traced_alloc(real_memalign(alignment, size), size);
+}
+
+void* valloc(size_t size){
+    if (!real_valloc) resolve();
+    return traced_alloc(real_valloc(size), size);
+}
+
+void* pvalloc(size_t size){
+    if (!real_pvalloc) resolve();
+    return traced_alloc(real_pvalloc(size), size);
+}